@@ -0,0 +1,171 @@
+#include "ConfigCatalog.h"
+
+#include <QDir>
+#include <QtConcurrent/QtConcurrent>
+
+#include "Core.h"
+#include "ConfigManager.h"
+#include "StartupProfiler.h"
+
+ConfigCatalog *ConfigCatalog::instance = nullptr;
+
+ConfigCatalog *ConfigCatalog::Instance()
+{
+    if (!instance)
+        instance = new ConfigCatalog();
+
+    return instance;
+}
+
+void ConfigCatalog::removeCatalog()
+{
+    if (instance)
+    {
+        delete instance;
+        instance = nullptr;
+    }
+}
+
+ConfigCatalog::ConfigCatalog(QObject *parent) : QObject(parent)
+{
+    m_watcher = new QFileSystemWatcher(this);
+    connect(m_watcher, &QFileSystemWatcher::directoryChanged, this, [=](const QString &path)
+    {
+        if (!m_built)
+            return;
+
+        // a module directory appeared or vanished
+        if (QDir(path) == QDir(Core::FolderConfigs))
+        {
+            scanModules();
+            return;
+        }
+
+        invalidate(QDir(path).dirName());
+    });
+}
+
+void ConfigCatalog::build()
+{
+    XO_PROFILE_SCOPE("ConfigCatalog::build");
+
+    m_configsByModule.clear();
+    m_moduleByClass.clear();
+    m_stale.clear();
+    if (!m_watcher->directories().isEmpty())
+        m_watcher->removePaths(m_watcher->directories());
+
+    QStringList moduleNames = QDir(Core::FolderConfigs).entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    QList<QJsonObject> configs = QtConcurrent::blockingMapped(moduleNames, std::function<QJsonObject(const QString&)>(
+        [](const QString &moduleName) { return ConfigManager::readConfiguration(Core::FolderConfigs + moduleName); }));
+
+    for (int i = 0; i < moduleNames.size(); i++)
+        insert(moduleNames[i], configs[i]);
+
+    if (QDir(Core::FolderConfigs).exists())
+        m_watcher->addPath(Core::FolderConfigs);
+    m_built = true;
+}
+
+void ConfigCatalog::scanModules()
+{
+    QSet<QString> present;
+    for (const QString &moduleName : QDir(Core::FolderConfigs).entryList(QDir::Dirs | QDir::NoDotAndDotDot))
+    {
+        present << moduleName;
+        if (!m_configsByModule.contains(moduleName))
+            invalidate(moduleName);
+    }
+
+    for (const QString &moduleName : m_configsByModule.keys())
+        if (!present.contains(moduleName))
+        {
+            remove(moduleName);
+            emit moduleChanged(moduleName);
+        }
+}
+
+void ConfigCatalog::invalidate(const QString &moduleName)
+{
+    if (m_stale.contains(moduleName))
+        return;
+
+    m_stale << moduleName;
+    emit moduleChanged(moduleName);
+}
+
+void ConfigCatalog::ensureCurrent()
+{
+    if (!m_built)
+        build();
+
+    for (const QString &moduleName : m_stale)
+    {
+        remove(moduleName);
+        QString path = Core::FolderConfigs + moduleName;
+        if (QDir(path).exists())
+            insert(moduleName, ConfigManager::readConfiguration(path));
+    }
+    m_stale.clear();
+}
+
+void ConfigCatalog::insert(const QString &moduleName, const QJsonObject &configs)
+{
+    m_configsByModule[moduleName] = configs;
+    for (const QString &className : configs.keys())
+        m_moduleByClass[className] = moduleName;
+
+    QString path = Core::FolderConfigs + moduleName;
+    if (!m_watcher->directories().contains(path))
+        m_watcher->addPath(path);
+}
+
+void ConfigCatalog::remove(const QString &moduleName)
+{
+    for (const QString &className : m_configsByModule.take(moduleName).keys())
+        if (m_moduleByClass.value(className) == moduleName)
+            m_moduleByClass.remove(className);
+
+    QString path = Core::FolderConfigs + moduleName;
+    if (m_watcher->directories().contains(path))
+        m_watcher->removePath(path);
+}
+
+bool ConfigCatalog::contains(const QString &moduleName)
+{
+    ensureCurrent();
+    return m_configsByModule.contains(moduleName);
+}
+
+QStringList ConfigCatalog::moduleNames()
+{
+    ensureCurrent();
+    return m_configsByModule.keys();
+}
+
+QJsonObject ConfigCatalog::moduleConfigs(const QString &moduleName)
+{
+    ensureCurrent();
+    return m_configsByModule.value(moduleName);
+}
+
+QJsonObject ConfigCatalog::classConfig(const QString &moduleName, const QString &className)
+{
+    ensureCurrent();
+    return m_configsByModule.value(moduleName).value(className).toObject();
+}
+
+QString ConfigCatalog::moduleOfClass(const QString &className)
+{
+    ensureCurrent();
+    return m_moduleByClass.value(className);
+}
+
+QJsonObject ConfigCatalog::toJson()
+{
+    ensureCurrent();
+    QJsonObject result;
+    for (auto it = m_configsByModule.constBegin(); it != m_configsByModule.constEnd(); ++it)
+        result[it.key()] = it.value();
+    return result;
+}
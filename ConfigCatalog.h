@@ -0,0 +1,58 @@
+#ifndef CONFIGCATALOG_H
+#define CONFIGCATALOG_H
+
+#include <QSet>
+#include <QHash>
+#include <QObject>
+#include <QJsonObject>
+#include <QFileSystemWatcher>
+#include "xoCore_global.h"
+
+//! In-memory copy of the module configs under Core::FolderConfigs, parsed once (in parallel)
+//! and kept current by a QFileSystemWatcher: a module whose directory changes is re-read on the
+//! next lookup. Configs are written through QSaveFile (a rename), so directory notifications
+//! are enough. Used from the main thread only.
+class XOCORESHARED_EXPORT ConfigCatalog : public QObject
+{
+    Q_OBJECT
+public:
+    static ConfigCatalog *Instance();
+    static void removeCatalog();
+
+    //! read every module directory, done by the first lookup too
+    void build();
+
+    bool contains(const QString &moduleName);
+    QStringList moduleNames();
+    //! className => class config, as ConfigManager::readConfiguration() returns it
+    QJsonObject moduleConfigs(const QString &moduleName);
+    QJsonObject classConfig(const QString &moduleName, const QString &className);
+    //! the module describing the class, empty if no config has it
+    QString moduleOfClass(const QString &className);
+    //! moduleName => moduleConfigs(), as ConfigManager::readConfigurations() returns it
+    QJsonObject toJson();
+
+    //! re-read the module on the next lookup (the watcher notices changes made by others)
+    void invalidate(const QString &moduleName);
+
+signals:
+    void moduleChanged(QString moduleName);
+
+private:
+    explicit ConfigCatalog(QObject *parent = nullptr);
+
+    static ConfigCatalog *instance;
+
+    QFileSystemWatcher *m_watcher;
+    bool m_built = false;
+    QHash<QString, QJsonObject> m_configsByModule;
+    QHash<QString, QString> m_moduleByClass;
+    QSet<QString> m_stale;
+
+    void ensureCurrent();
+    void insert(const QString &moduleName, const QJsonObject &configs);
+    void remove(const QString &moduleName);
+    void scanModules();
+};
+
+#endif // CONFIGCATALOG_H
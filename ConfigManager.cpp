@@ -1,79 +1,139 @@
 #include "Core.h"
 #include "ConfigManager.h"
+#include "ConfigCatalog.h"
 #include "fileutilities.h"
+#include "PersistenceWorker.h"
+#include "StartupProfiler.h"
 
 #include <QDir>
 #include <QFile>
+#include <QFileInfo>
 #include <QByteArray>
 #include <QJsonArray>
 #include <QJsonDocument>
+#include <QSharedPointer>
+#include <QFutureWatcher>
+#include <QFutureInterface>
 
-void ConfigManager::writeModuleConfig(ModuleProxyONB *module)
+QFuture<bool> ConfigManager::writeModuleConfig(ModuleProxyONB *module)
 {
-    if(!module) return;
+    if(!module) return QFuture<bool>();
 
+    XO_PROFILE_SCOPE("ConfigManager::writeModuleConfig", module->name());
     QString path = Core::FolderConfigs + module->name() + "/";
-    verifyDir(module->name());
+    QList<QFuture<bool>> results;
+    if(!module->iconData().isEmpty())
+        results << writeIcon(module->iconData(), path + module->name() + ".png");
 
-    auto image = module->icon();
+    for(auto& name : module->classNames())
+    {
+        results << writeComponentConfig(module, module->classInfo(name));
+    }
+
+    return whenAll(results);
+}
 
-    if(!image.isNull())
+QFuture<bool> ConfigManager::whenAll(const QList<QFuture<bool>> &futures)
+{
+    // the worker runs jobs in queue order and merges jobs of a path, so any of them may finish last
+    struct Joint
     {
-        image.convertToFormat(QImage::Format_RGBA8888);
+        QFutureInterface<bool> result;
+        int pending = 0;
+        bool ok = true;
+    };
 
-        if (image.size() != QSize(24, 24))
-        {
-            image = image.scaled(24, 24, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
-        }
-        image.save(path + module->name() + ".png");
+    auto joint = QSharedPointer<Joint>::create();
+    joint->result.reportStarted();
+    joint->pending = futures.size();
+
+    auto finish = [joint]()
+    {
+        joint->result.reportResult(joint->ok);
+        joint->result.reportFinished();
+    };
+
+    if(!joint->pending)
+    {
+        finish();
+        return joint->result.future();
     }
 
-    for(auto& name : module->classNames())
+    for(auto future : futures)
     {
-        writeComponentConfig(module, module->classInfo(name));
+        auto watcher = new QFutureWatcher<bool>();
+        QObject::connect(watcher, &QFutureWatcher<bool>::finished, watcher, [=]()
+        {
+            joint->ok = joint->ok && !future.isCanceled() && future.resultCount() > 0 && future.result();
+            watcher->deleteLater();
+            if(--joint->pending == 0) finish();
+        });
+        watcher->setFuture(future);
     }
+
+    return joint->result.future();
 }
 
-void ConfigManager::writeComponentConfig(ModuleProxyONB* module, ComponentProxyONB *component)
+QFuture<bool> ConfigManager::writeComponentConfig(ModuleProxyONB* module, ComponentProxyONB *component)
 {
-    QElapsedTimer t; t.restart();
-
     QString path = Core::FolderConfigs + module->name() + "/";
-    verifyDir(module->name());
-
     QString filepath = path + component->componentType() + Core::FileExtensionConfigDot;
-    QFile file(filepath);
+    QString iconPath = path + module->name() + "_" + component->componentType() + ".png";
+    QString componentType = component->componentType();
+
+    // everything is captured by value here, the component may be gone when the job runs
+    QJsonObject info = component->getInfoJson();
+    QByteArray iconData = component->iconData();
 
-    if(!file.exists())
+    QFuture<bool> result = PersistenceWorker::Instance()->enqueue(filepath, [=]()
     {
-        if(file.open(QIODevice::WriteOnly|QIODevice::Truncate))
+        if(QFile::exists(filepath))
         {
-            file.write(QJsonDocument(component->getInfoJson()).toJson(QJsonDocument::Compact));
-            file.close();
+            qDebug() << "Config exists" << componentType;
+            return true;
         }
 
-        QImage image;
-        if(!component->icon().isNull())
-          image = component->icon();
+        QElapsedTimer t; t.restart();
 
-        if(!image.isNull())
-        {
-            image.convertToFormat(QImage::Format_RGBA8888);
-            if (image.size() != QSize(24, 24))
-            {
-                image = image.scaled(24, 24, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
-            }
-            image.save(path + module->name() + "_" + component->componentType() + ".png");
-        }
+        bool ok = PersistenceWorker::writeFileNow(filepath, QJsonDocument(info).toJson(QJsonDocument::Compact));
+        saveIcon(iconData, iconPath);
 
-        qDebug() << "Config for component written" << component->componentType() << t.elapsed();
-    }
-    else
+        qDebug() << "Config for component written" << componentType << t.elapsed();
+        return ok;
+    });
+
+    // the catalog would learn it from its watcher too, but only after configWritten is handled
+    QString moduleName = module->name();
+    auto watcher = new QFutureWatcher<bool>(ConfigCatalog::Instance());
+    QObject::connect(watcher, &QFutureWatcher<bool>::finished, ConfigCatalog::Instance(), [=]()
     {
-        qDebug() << "Config exists" << component->componentType() << t.elapsed();
-    }
+        ConfigCatalog::Instance()->invalidate(moduleName);
+        watcher->deleteLater();
+    });
+    watcher->setFuture(result);
 
+    return result;
+}
 
+QFuture<bool> ConfigManager::writeIcon(const QByteArray &iconData, const QString &path)
+{
+    return PersistenceWorker::Instance()->enqueue(path, [=]() { return saveIcon(iconData, path); });
+}
+
+bool ConfigManager::saveIcon(const QByteArray &iconData, const QString &path)
+{
+    QImage image = QImage::fromData(iconData);
+    if(image.isNull())
+        return false;
+
+    image = image.convertToFormat(QImage::Format_RGBA8888);
+    if (image.size() != QSize(24, 24))
+    {
+        image = image.scaled(24, 24, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    }
+
+    FileUtilities::createIfNotExists(QFileInfo(path).absolutePath() + "/");
+    return image.save(path);
 }
 
 ConfigManager::ConfigManager()
@@ -83,21 +143,12 @@ ConfigManager::ConfigManager()
 
 bool ConfigManager::moduleConfigsExist(QString moduleName)
 {
-    return QDir(Core::FolderConfigs + moduleName + "/").exists();
+    return ConfigCatalog::Instance()->contains(moduleName);
 }
 
 QJsonObject ConfigManager::readConfigurations()
 {
-    QString configsPath = Core::FolderConfigs;
-
-    QJsonObject result;
-
-    for(auto& moduleName : QDir(configsPath).entryList(QDir::Dirs | QDir::NoDotAndDotDot))
-    {
-        result[moduleName] = ConfigManager::readConfiguration(configsPath + moduleName);
-    }
-
-    return result;
+    return ConfigCatalog::Instance()->toJson();
 }
 
 QByteArray ConfigManager::jsonToByteArray(const QJsonObject &in_obj)
@@ -2,6 +2,7 @@
 #define CONFIGMANAGER_H
 
 #include <QObject>
+#include <QFuture>
 #include <QJsonObject>
 
 #include "Module/ModuleProxyONB.h"
@@ -10,10 +11,14 @@ class XOCORESHARED_EXPORT ConfigManager : public QObject
 {
     Q_OBJECT
 public:
-    static void writeModuleConfig(ModuleProxyONB *module);
-    static void writeComponentConfig(ModuleProxyONB *module, ComponentProxyONB* component);
+    //! configs and icons are written on the persistence thread,
+    //! the returned future finishes when the last of them is on disk and is true if all were written
+    static QFuture<bool> writeModuleConfig(ModuleProxyONB *module);
+    static QFuture<bool> writeComponentConfig(ModuleProxyONB *module, ComponentProxyONB* component);
     static bool moduleConfigsExist(QString moduleName);
+    //! served from ConfigCatalog
     static QJsonObject readConfigurations();
+    //! parses the directory, ConfigCatalog::moduleConfigs() is the cached way
     static QJsonObject readConfiguration(QString in_path);
 
 protected:
@@ -26,6 +31,10 @@ protected:
 
 private:
     static void verifyDir(QString moduleName);
+    //! finishes when all of the futures have, with the AND of their results
+    static QFuture<bool> whenAll(const QList<QFuture<bool>> &futures);
+    static QFuture<bool> writeIcon(const QByteArray &iconData, const QString &path);
+    static bool saveIcon(const QByteArray &iconData, const QString &path);
     ConfigManager();
 };
 
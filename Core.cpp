@@ -1,4 +1,10 @@
 #include "Core.h"
+#include "SchemeCache.h"
+#include "SchemeJournal.h"
+#include "ConfigCatalog.h"
+#include "PersistenceWorker.h"
+#include "Tracer.h"
+#include "StartupProfiler.h"
 #include "ModuleBaseLibONB.h"
 #include "GlobalConsole.h"
 #include "fileutilities.h"
@@ -8,6 +14,10 @@
 #include <QLocalSocket>
 #include <QPluginLoader>
 #include <QMessageBox>
+#include <QTimer>
+#include <QFileInfo>
+#include <QEventLoop>
+#include <QFutureWatcher>
 
 QString Core::FolderConfigs = "xoConfigs/";
 QString Core::FolderSchemes = "xoSchemes/";
@@ -16,6 +26,7 @@ QString Core::FolderModules = "xoModules/";
 QString Core::FolderCorePlugins = "xoCorePlugins/";
 QString Core::FolderLaunchers = "xoLaunchers/";
 QString Core::FolderScripts = "xoScripts/";
+QString Core::FolderCache = "xoCache/";
 
 #ifdef Q_OS_WIN
 
@@ -66,6 +77,11 @@ Core::Core(QObject *parent) : QObject(parent)
 Core::~Core()
 {
     ModuleList::removeList();
+    StartupProfiler::finish();
+    PersistenceWorker::removeWorker();
+    ConfigCatalog::removeCatalog();
+    stopScriptEngine();
+    Tracer::shutdown();
 }
 
 ComponentInfo* Core::createComponentInScheme(QString componentType, QString moduleName)
@@ -142,6 +158,9 @@ bool Core::deleteScheme(QString schemePath)
         m_scheme->clear();
     }
 
+    SchemeCache::remove(schemePath);
+    SchemeJournal::remove(schemePath);
+
     return QFile::remove(schemePath);
 }
 
@@ -149,8 +168,21 @@ void Core::init(QString launchConfigPath)
 {
     qRegisterMetaType<ONBPacket>("ONBPacket");
 
+    Tracer::addSink(new ConsoleTraceSink());
+    Tracer::configure(QString::fromLocal8Bit(qgetenv("XO_TRACE")));
+
     QString appPath = QCoreApplication::applicationDirPath() + "/";
 
+    QStringList arguments = QCoreApplication::arguments();
+    int traceArgument = arguments.indexOf("--startup-trace");
+    if (traceArgument >= 0)
+    {
+        bool hasPath = traceArgument + 1 < arguments.size() && !arguments[traceArgument + 1].startsWith("-");
+        StartupProfiler::start(hasPath ? arguments[traceArgument + 1] : appPath + "startup.trace.json");
+        QTimer::singleShot(StartupProfiler::MaxDurationMs, this, []() { StartupProfiler::finish(); });
+    }
+    XO_PROFILE_SCOPE("Core::init");
+
     FolderConfigs.prepend(appPath);
     FolderSchemes.prepend(appPath);
     FolderPlugins.prepend(appPath);
@@ -158,32 +190,62 @@ void Core::init(QString launchConfigPath)
     FolderCorePlugins.prepend(appPath);
     FolderLaunchers.prepend(appPath);
     FolderScripts.prepend(appPath);
+    FolderCache.prepend(appPath);
 
-    FileUtilities::createIfNotExists(FolderConfigs);
-    FileUtilities::createIfNotExists(FolderSchemes);
-    FileUtilities::createIfNotExists(FolderPlugins);
-    FileUtilities::createIfNotExists(FolderModules);
-    FileUtilities::createIfNotExists(FolderLaunchers);
-    FileUtilities::createIfNotExists(FolderScripts);
+    {
+        XO_PROFILE_SCOPE("create folders");
+        FileUtilities::createIfNotExists(FolderConfigs);
+        FileUtilities::createIfNotExists(FolderSchemes);
+        FileUtilities::createIfNotExists(FolderPlugins);
+        FileUtilities::createIfNotExists(FolderModules);
+        FileUtilities::createIfNotExists(FolderLaunchers);
+        FileUtilities::createIfNotExists(FolderScripts);
+        FileUtilities::createIfNotExists(FolderCache);
+    }
 
-    m_server = new Server(this);
-    m_server->startListening();
+    {
+        XO_PROFILE_SCOPE("Server::startListening");
+        m_server = new Server(this);
+        m_server->startListening();
+    }
+    connect(PluginManager::Instance(), &PluginManager::inProcessModule, m_server, &Server::addInProcessModule);
 
     m_scheme = new Scheme(this);
     connect(m_scheme, &Scheme::loaded, this, [=]() { GlobalConsole::writeLine("Scheme loaded: " + m_scheme->getLastLoadedPath()); }, Qt::QueuedConnection);
 
     setProperty("name", "core");
 
-    m_scriptEngine = new ScriptEngineWrapper(this);
-    m_scriptEngine->addVariable(this);
+    // the engine lives in its own thread, components are accessed through the bridge
+    m_scriptBridge = new ScriptBridge(this);
+    m_scriptBridge->track(this);
+
+    m_scriptThread = new QThread(this);
+    m_scriptThread->setObjectName("xoScript");
+    m_scriptEngine = new ScriptEngineWrapper(m_scriptBridge);
+    m_scriptEngine->moveToThread(m_scriptThread);
+    m_scriptThread->start();
+
+    QMetaObject::invokeMethod(m_scriptEngine, "addVariable", Qt::QueuedConnection, Q_ARG(QObject*, this));
 
     m_hub = new Hub(this);
     m_hub->setScheme(m_scheme);
 
     connect(m_hub, &Hub::enableChanged, this, [=](bool enabled) { GlobalConsole::writeLine(QString("Scheme ") + (enabled ? "started" : "stopped")); }, Qt::QueuedConnection);
+    // boot ends when the scheme runs
+    connect(m_hub, &Hub::enableChanged, this, [](bool enabled)
+    {
+        if (!enabled) return;
+        StartupProfiler::instant("startup", "scheme started");
+        StartupProfiler::finish();
+    });
 
     m_loader = new Loader(m_server, m_hub, this);
-    m_loader->load(launchConfigPath);
+    m_loader->setUnloadIdlePlugins(arguments.contains("--unload-idle-plugins"));
+    connect(m_loader, &Loader::schemeModulesReady, m_hub, &Hub::startPendingScheme);
+    {
+        XO_PROFILE_SCOPE("Loader::load");
+        m_loader->load(launchConfigPath);
+    }
 
     auto localServer = new QLocalServer(this);
     if(!localServer->listen("xorde_local"))
@@ -200,10 +262,13 @@ void Core::init(QString launchConfigPath)
         connect(socket, &QLocalSocket::readyRead, socket, [=](){ if(socket->readAll() == "close") QCoreApplication::quit(); });
     });
 
-    connect(m_hub, &Hub::componentAdded, m_scriptEngine, &ScriptEngineWrapper::addVariable);
-    connect(m_hub, &Hub::componentKilled, m_scriptEngine, &ScriptEngineWrapper::deleteVariable);
-    connect(m_hub, &Hub::componentRenamed, m_scriptEngine, &ScriptEngineWrapper::renameVariable);
-    connect(m_hub, &Hub::componentChanged, m_scriptEngine, &ScriptEngineWrapper::addVariable);
+    // tracking has to happen here, before the engine gets the object
+    connect(m_hub, &Hub::componentAdded, m_scriptBridge, &ScriptBridge::track);
+    connect(m_hub, &Hub::componentChanged, m_scriptBridge, &ScriptBridge::track);
+    connect(m_hub, &Hub::componentAdded, m_scriptEngine, &ScriptEngineWrapper::addVariable, Qt::QueuedConnection);
+    connect(m_hub, &Hub::componentKilled, m_scriptEngine, &ScriptEngineWrapper::deleteVariable, Qt::QueuedConnection);
+    connect(m_hub, &Hub::componentRenamed, m_scriptEngine, &ScriptEngineWrapper::renameVariable, Qt::QueuedConnection);
+    connect(m_hub, &Hub::componentChanged, m_scriptEngine, &ScriptEngineWrapper::addVariable, Qt::QueuedConnection);
 }
 
 Server *Core::getServer()
@@ -221,6 +286,11 @@ Loader *Core::getLoader()
     return m_loader;
 }
 
+QVariantMap Core::moduleStats()
+{
+    return m_loader->getMonitor()->stats().toVariantMap();
+}
+
 ScriptEngineWrapper *Core::getEngine()
 {
     return m_scriptEngine;
@@ -230,11 +300,57 @@ QString Core::executeJavaScript(const QString &text)
 {
     if (m_scriptEngine)
     {
-        return m_scriptEngine->evaluate(text).toString();
+        return waitForScript(m_scriptEngine->evaluateAsync(text));
     }
     return "?";
 }
 
+QString Core::runScript(QString scriptPath)
+{
+    if (!m_scriptEngine)
+        return "?";
+
+    if (QFileInfo(scriptPath).isRelative())
+        scriptPath.prepend(FolderScripts);
+    if (!scriptPath.endsWith(FileExtensionScriptDot))
+        scriptPath.append(FileExtensionScriptDot);
+
+    return waitForScript(m_scriptEngine->evaluateFileAsync(scriptPath));
+}
+
+QString Core::waitForScript(QFuture<QString> future)
+{
+    // the script calls back into this thread, so events have to be processed while waiting
+    if (!future.isFinished())
+    {
+        QEventLoop loop;
+        QFutureWatcher<QString> watcher;
+        connect(&watcher, &QFutureWatcher<QString>::finished, &loop, &QEventLoop::quit);
+        watcher.setFuture(future);
+        if (!future.isFinished())
+            loop.exec();
+    }
+    return future.result();
+}
+
+void Core::stopScriptEngine()
+{
+    if (!m_scriptThread)
+        return;
+
+    auto engine = m_scriptEngine;
+    QTimer::singleShot(0, engine, [=]() { if (engine->isEvaluating()) engine->abortEvaluation(); });
+    m_scriptThread->quit();
+
+    // a running script may be blocked on a call into this thread
+    while (!m_scriptThread->wait(20))
+        QCoreApplication::sendPostedEvents(m_scriptBridge, QEvent::MetaCall);
+
+    delete m_scriptEngine;
+    m_scriptEngine = nullptr;
+    m_scriptThread = nullptr;
+}
+
 Scheme *Core::getScheme()
 {
     return m_scheme;
@@ -2,6 +2,7 @@
 #define CORE_H
 
 #include <QObject>
+#include <QThread>
 #include <QJsonObject>
 
 #include "xoCore_global.h"
@@ -14,6 +15,7 @@
 #include "xoCorePlugin.h"
 #include "PluginManager.h"
 #include "ConfigManager.h"
+#include "ScriptBridge.h"
 #include "ScriptEngineWrapper.h"
 #include "Module/ComponentProxyONB.h"
 
@@ -36,6 +38,7 @@ public:
     static QString FolderCorePlugins;
     static QString FolderLaunchers;
     static QString FolderScripts;
+    static QString FolderCache;
 
     static const QString FileExtensionScheme;
     static const QString FileExtensionConfig;
@@ -55,9 +58,16 @@ public:
     Scheme *getScheme();
     Hub *getHub();
     Loader* getLoader();
+    //! the engine lives in the script thread: from other threads only its thread-safe calls
+    //! (evaluateAsync, evaluateFileAsync) and queued slot invocations may be used
     ScriptEngineWrapper* getEngine();
 
+    //! ModuleMonitor::stats() in a form scripts can read: core.moduleStats()["name"].cpuPercent
+    Q_INVOKABLE QVariantMap moduleStats();
+
     QString executeJavaScript(const QString &text);
+    //! name in FolderScripts or a path, the compiled script is cached until the file changes
+    QString runScript(QString scriptPath);
 
     bool loadScheme(QString schemePath);
     bool deleteScheme(QString schemePath);
@@ -75,6 +85,11 @@ private:
     Hub *m_hub = nullptr;
     Loader* m_loader = nullptr;
     ScriptEngineWrapper* m_scriptEngine = nullptr;
+    ScriptBridge* m_scriptBridge = nullptr;
+    QThread* m_scriptThread = nullptr;
+
+    QString waitForScript(QFuture<QString> future);
+    void stopScriptEngine();
 
     QMap<QString, int> m_componentCountByModuleName;
 };
@@ -28,6 +28,8 @@ ComponentConnection *ComponentConnection::fromJson(QJsonObject &object)
     QString inputName = object.value("inputName").toString();
     QString inputType = object.value("inputType").toString();
     int RMIP = object.value("RMIP").toInt();
+    bool deltaMode = object.value("delta").toBool();
+    LinkFilter::Settings filter = LinkFilter::Settings::fromJson(object.value("filter").toObject());
 
     //TODO: consistency check
 
@@ -40,6 +42,8 @@ ComponentConnection *ComponentConnection::fromJson(QJsonObject &object)
                                               inputName,
                                               inputType,
                                               RMIP);
+    connection->deltaMode = deltaMode;
+    connection->filter = filter;
 
     return connection;
 }
@@ -56,5 +60,9 @@ QJsonObject ComponentConnection::toJsonObject()
     connectionObject.insert("inputName", inputName);
     connectionObject.insert("inputType", inputType);
     connectionObject.insert("RMIP", RMIP);
+    if (deltaMode)
+        connectionObject.insert("delta", true);
+    if (!filter.isEmpty())
+        connectionObject.insert("filter", filter.toJson());
     return connectionObject;
 }
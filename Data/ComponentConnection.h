@@ -3,6 +3,7 @@
 
 #include <QObject>
 #include <QJsonObject>
+#include "Module/LinkFilter.h"
 #include "xoCore_global.h"
 
 class XOCORESHARED_EXPORT ComponentConnection : public QObject
@@ -29,9 +30,13 @@ public:
     QString inputType;
 
     bool isEnabled = true;
+    bool deltaMode = false; //!< block-level changes of large values, from the output and to the input
+    LinkFilter::Settings filter; //!< reduction of numeric values computed in the core
 
     int RMIP; //рекомендуемый минимальный интервал передачи
 
+    int schemeIndex = -1; //!< position in Scheme::connections, maintained by Scheme
+
     QString compoundString()
     {
         QString connStr = "";
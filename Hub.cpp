@@ -1,5 +1,6 @@
 #include "Hub.h"
 
+#include <QTimer>
 #include <QThread>
 #include <QObject>
 #include <QSharedPointer>
@@ -7,10 +8,31 @@
 #include "ConfigManager.h"
 #include "Core.h"
 #include "GlobalConsole.h"
+#include "Tracer.h"
+#include "StartupProfiler.h"
 
 
 Hub::Hub(QObject *parent) : QObject(parent)
 {
+    m_enableTimer = new QTimer(this);
+    m_enableTimer->setSingleShot(true);
+    m_enableTimer->setInterval(Loader::SchemeReadyTimeoutMs);
+    connect(m_enableTimer, &QTimer::timeout, this, [=]()
+    {
+        XO_TRACE_WARNING(Hub, "scheme modules are not ready in time, starting anyway");
+        startPendingScheme();
+    });
+
+    m_settingsTimer = new QTimer(this);
+    m_settingsTimer->setSingleShot(true);
+    m_settingsTimer->setInterval(SettingsStoreDelayMs);
+    connect(m_settingsTimer, &QTimer::timeout, this, [=]()
+    {
+        QSet<QString> changed;
+        changed.swap(m_settingsChanged);
+        for (const QString &componentName : changed)
+            storeComponentSettings(componentName);
+    });
 }
 
 void Hub::setScheme(Scheme *scheme)
@@ -35,7 +57,7 @@ void Hub::addModule(ModuleProxyONB *module)
 
     m_moduleConnections << connect(module, &ModuleProxyONB::newComponent, [=]()
     {
-        qDebug() << "COMP NEW in module" << module->name();
+        XO_TRACE_DEBUG(Hub, "component new in module", module->name());
         module->assignComponentID(componentID);
         componentID++;
     });
@@ -49,15 +71,16 @@ void Hub::addModule(ModuleProxyONB *module)
             ConfigManager::writeComponentConfig(module, component);
             componentsByName[component->componentName()] = component;
             emit componentAdded(component);
-            qDebug() << "COMP ADDED" << component->componentName();
+            XO_TRACE_DEBUG(Hub, "component added", component->componentName());
             reloadComponentSettingsFromScheme(component->componentName());
+            watchSettings(component);
 
             linkComponentConnections(component, m_isEnabled);
         });
 
         m_moduleConnections << connect(component, &ComponentProxyONB::infoChanged, [=]()
         {
-            qDebug() << "COMP CHANGED" << component->componentName();
+            XO_TRACE_DEBUG(Hub, "component changed", component->componentName());
 
             QString name = component->componentName();
             if (componentsByName[name] != component) // component was renamed
@@ -126,8 +149,41 @@ void Hub::removeModule(QString name)
 
 void Hub::setIsEnabled(bool enabled)
 {
+    if (!enabled)
+    {
+        m_enablePending = false;
+        m_enableTimer->stop();
+    }
+
     if (m_isEnabled == enabled) return;
 
+    // links made now would miss the components of modules that are still starting
+    auto loader = Core::Instance()->getLoader();
+    if (enabled && loader && !loader->areSchemeModulesReady())
+    {
+        if (!m_enablePending)
+        {
+            XO_TRACE_INFO(Hub, "scheme start deferred until its modules are ready");
+            m_enableTimer->start();
+        }
+        m_enablePending = true;
+        return;
+    }
+
+    applyIsEnabled(enabled);
+}
+
+void Hub::startPendingScheme()
+{
+    if (!m_enablePending) return;
+
+    m_enablePending = false;
+    m_enableTimer->stop();
+    applyIsEnabled(true);
+}
+
+void Hub::applyIsEnabled(bool enabled)
+{
     m_isEnabled = enabled;
 
     emit enableChanged(enabled);
@@ -146,6 +202,9 @@ void Hub::setIsEnabled(bool enabled)
 
 void Hub::linkConnection(ComponentConnection *connection, bool shouldConnect)
 {
+    // a filter is made for every link, it must not outlive it
+    delete m_linkFilters.take(connection->compoundString());
+
     auto compOut = getComponentByName(connection->outputComponentName);
     auto compIn = getComponentByName(connection->inputComponentName);
     if (compOut && compIn)
@@ -158,18 +217,84 @@ void Hub::linkConnection(ComponentConnection *connection, bool shouldConnect)
             if(m_isEnabled && shouldConnect)
             {
                 int RMIP = (connection->RMIP > 0) ? connection->RMIP : objOut->RMIP;
-                ObjectProxy::link(objOut, objIn);
+
+                LinkFilter *filter = nullptr;
+                if (!connection->filter.isEmpty() && LinkFilter::isNumeric(objOut) && LinkFilter::isNumeric(objIn))
+                {
+                    filter = new LinkFilter(connection->filter, objOut, objIn, this);
+                    m_linkFilters[connection->compoundString()] = filter;
+                }
+
+                ObjectProxy::link(objOut, objIn, filter);
+                objIn->setDeltaMode(connection->deltaMode);
+                if (connection->deltaMode)
+                    compOut->requestDelta(connection->outputName, true);
                 compOut->subscribe(connection->outputName, RMIP);
             }
             else
             {
                 ObjectProxy::unlink(objOut, objIn);
+                objIn->setDeltaMode(false);
+                if (connection->deltaMode)
+                    compOut->requestDelta(connection->outputName, false);
                 compOut->unsubscribe(connection->outputName);
             }
         }
     }
 }
 
+QJsonObject Hub::linkFilterStats()
+{
+    QJsonObject result;
+    for(auto it = m_linkFilters.constBegin(); it != m_linkFilters.constEnd(); ++it)
+    {
+        const LinkFilter::Stats &stats = it.value()->stats();
+        QJsonObject link;
+        link["received"] = static_cast<double>(stats.received);
+        link["forwarded"] = static_cast<double>(stats.forwarded);
+        link["suppressed"] = static_cast<double>(stats.suppressed);
+        result[it.key()] = link;
+    }
+    return result;
+}
+
+QJsonObject Hub::deltaStats()
+{
+    QJsonObject result;
+    if (!m_scheme) return result;
+
+    auto statsJson = [](const DeltaCodec::Stats &stats)
+    {
+        QJsonObject json;
+        json["frames"] = static_cast<double>(stats.frames);
+        json["keyframes"] = static_cast<double>(stats.keyframes);
+        json["rawBytes"] = static_cast<double>(stats.rawBytes);
+        json["sentBytes"] = static_cast<double>(stats.sentBytes);
+        json["ratio"] = stats.ratio();
+        return json;
+    };
+
+    for(auto connection : m_scheme->connections)
+    {
+        if (!connection->deltaMode) continue;
+
+        auto compOut = getComponentByName(connection->outputComponentName);
+        auto compIn = getComponentByName(connection->inputComponentName);
+        auto objOut = compOut ? compOut->object(connection->outputName) : nullptr;
+        auto objIn = compIn ? compIn->object(connection->inputName) : nullptr;
+
+        // "inbound" is the publisher to the core, "outbound" the core to the subscriber
+        QJsonObject link;
+        if (objOut && objOut->deltaReceived())
+            link["inbound"] = statsJson(*objOut->deltaReceived());
+        if (objIn && objIn->deltaCodec())
+            link["outbound"] = statsJson(objIn->deltaCodec()->stats());
+        if (!link.isEmpty())
+            result[connection->compoundString()] = link;
+    }
+    return result;
+}
+
 bool Hub::isEnabled()
 {
     return m_isEnabled;
@@ -204,6 +329,8 @@ void Hub::clearConnections()
 
 void Hub::checkCurrentSchemeComponents()
 {
+    XO_PROFILE_SCOPE("Hub::checkCurrentSchemeComponents");
+
     if (!m_scheme)
     {
         for(auto module : getModules())
@@ -232,7 +359,10 @@ void Hub::checkCurrentSchemeComponents()
             auto module = getModuleByName(compHeader.moduleName);
 
             if (module)
+            {
+                module->requestClass(compHeader.componentType);
                 module->createComponent(compHeader.componentType, compHeader.componentName);
+            }
         }
     };
 
@@ -301,6 +431,39 @@ void Hub::reloadComponentSettingsFromScheme(ComponentInfo *info)
     }
 }
 
+void Hub::watchSettings(ComponentProxyONB *component)
+{
+    // ready comes again when classes are re-described, the connections must not pile up
+    for (auto setting : component->getSettings())
+        connect(setting, &ObjectProxy::valueChanged, this, &Hub::settingChanged, Qt::UniqueConnection);
+}
+
+void Hub::settingChanged()
+{
+    auto setting = qobject_cast<ObjectProxy*>(sender());
+    if (!setting || !setting->component())
+        return;
+
+    m_settingsChanged << setting->component()->componentName();
+    m_settingsTimer->start();
+}
+
+void Hub::storeComponentSettings(QString componentName)
+{
+    if (!m_scheme) return;
+
+    auto info = m_scheme->components.value(componentName, nullptr);
+    auto component = getComponentByName(componentName);
+    if (!info || !component) return;
+
+    ONBSettings settings(component);
+    QJsonObject json = settings.metaDescriptor()->saveToJson();
+    if (json == info->settings) return;
+
+    info->settings = json;
+    m_scheme->updateComponent(info);
+}
+
 void Hub::linkComponentConnections(ComponentProxyONB *component, bool shouldConnect)
 {
     for(auto&& output : component->getOutputs())
@@ -2,6 +2,8 @@
 #define HUB_H
 
 #include <queue>
+#include <QSet>
+#include <QTimer>
 #include <QObject>
 #include <QFuture>
 #include <QFutureWatcher>
@@ -51,10 +53,16 @@ public:
     void addModule(ModuleProxyONB *connection);
     void removeModule(QString name);
 
+    //! enabling waits for the modules of the scheme to be ready (see Loader::schemeModulesReady)
     void setIsEnabled(bool enabled);
     void linkConnection(ComponentConnection* connection, bool shouldConnect);
     bool isEnabled();
 
+    //! compression of links in delta mode by connection, both legs: publisher to core and core to subscriber
+    Q_INVOKABLE QJsonObject deltaStats();
+    //! samples received and forwarded by filtered links, by connection
+    Q_INVOKABLE QJsonObject linkFilterStats();
+
     QList<ModuleProxyONB*> getModules();
     ModuleProxyONB *getModuleByName(const QString &name);
     ComponentProxyONB* getComponentByName(QString name);
@@ -62,6 +70,10 @@ public:
 
 public slots:
     void checkCurrentSchemeComponents();
+    //! take the current settings of the component into the scheme (journaled if they changed)
+    void storeComponentSettings(QString componentName);
+    //! enable the scheme if it waits for its modules
+    void startPendingScheme();
 
 signals:
     void moduleReady(ModuleProxyONB *module);
@@ -77,6 +89,11 @@ protected:
     void reloadComponentSettingsFromScheme(ComponentInfo *compInfo);
     void linkComponentConnections(ComponentProxyONB* component, bool shouldConnect);
 
+protected slots:
+    void settingChanged();
+
+protected:
+
     ConnectionHelper m_schemeConnections;
     ConnectionHelper m_moduleConnections;
     ConnectionHelper m_pluginConnections;
@@ -84,6 +101,18 @@ protected:
     Scheme* m_scheme = nullptr;
 
     bool m_isEnabled = false;
+    bool m_enablePending = false;
+    QTimer *m_enableTimer = nullptr;
+
+    QHash<QString, LinkFilter*> m_linkFilters; //!< by ComponentConnection::compoundString()
+
+    void applyIsEnabled(bool enabled);
+
+    //! settings edits are stored into the scheme once they settle
+    static const int SettingsStoreDelayMs = 500;
+    QTimer *m_settingsTimer = nullptr;
+    QSet<QString> m_settingsChanged;
+    void watchSettings(ComponentProxyONB *component);
 
     QHash<QString, ModuleProxyONB*> modulesByName;
     QHash<QString, ComponentProxyONB*> componentsByName;
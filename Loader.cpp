@@ -2,16 +2,32 @@
 #include "Loader.h"
 #include "ModuleList.h"
 #include "ModuleConfig.h"
+#include "ConfigCatalog.h"
 #include "GlobalConsole.h"
+#include "Tracer.h"
+#include "StartupProfiler.h"
 #include "xoPrimitiveConsole.h"
 
 #include <QDir>
 #include <QApplication>
+#include <QPointer>
+#include <QFutureWatcher>
 #include <QPluginLoader>
 
 Loader::Loader(Server *server, Hub *hub, QObject *parent) : QObject(parent), server(server), hub(hub)
 {
+    supervisor = new ModuleSupervisor(this);
 
+    monitor = new ModuleMonitor(hub, this);
+
+    warmPool = new ModuleWarmPool(this);
+    connect(warmPool, &ModuleWarmPool::expired, this, [=](QString applicationName) { stopApplication(applicationName); });
+
+    connect(supervisor, &ModuleSupervisor::restartDue, this, [=](QString applicationName)
+    {
+        if(Core::Instance()->getScheme()->componentCountByModule.value(applicationName) > 0)
+            startApplication(applicationName);
+    });
 }
 
 Loader::~Loader()
@@ -28,6 +44,8 @@ Loader::~Loader()
 
 void Loader::load(QString launchConfigPath)
 {
+    startupClock.start();
+
     connect(server, &Server::moduleConnection, this, [=](ModuleProxyONB *module)
     {
         if (!module)
@@ -36,15 +54,23 @@ void Loader::load(QString launchConfigPath)
             return;
         }
 
+        // remote modules have no binary here and are always described by themselves
+        module->setClassCache(Core::FolderCache + module->name(), ClassCache::buildHash(appPathsByName.value(module->name())));
+
+        bool configured = ConfigManager::moduleConfigsExist(module->name());
+
+        // the config lists every class, otherwise only classes of the scheme are described
+        if(!configured)
+            module->requireAllClasses();
+
         hub->addModule(module);
 
-        
+        QString moduleName = module->name();
+        setModuleState(moduleName, module->isReady() ? ModuleReady : ModuleConnected);
+        connect(module, &ModuleProxyONB::ready, this, [=]() { setModuleState(moduleName, ModuleReady); });
         connect(module, &ModuleProxyONB::ready, module, [=]() { hub->checkCurrentSchemeComponents(); }, Qt::QueuedConnection);
 
-        QString configsPath = Core::FolderConfigs + module->name();
-        QDir dir(configsPath);
-
-        if(dir.exists())
+        if(configured)
         {
             moduleByName[module->name()] = module;
             emit configWritten(module);
@@ -55,8 +81,15 @@ void Loader::load(QString launchConfigPath)
         {
             moduleByName[module->name()] = module;
 
-            ConfigManager::writeModuleConfig(module);
-            emit configWritten(module);
+            auto watcher = new QFutureWatcher<bool>(this);
+            // the module may be removed while its configs are being written
+            QPointer<ModuleProxyONB> writtenModule = module;
+            connect(watcher, &QFutureWatcher<bool>::finished, this, [=]()
+            {
+                watcher->deleteLater();
+                if(writtenModule) emit configWritten(writtenModule);
+            });
+            watcher->setFuture(ConfigManager::writeModuleConfig(module));
 
             disconnect(moduleConnectsModuleName[module->name()]);
 
@@ -69,8 +102,24 @@ void Loader::load(QString launchConfigPath)
 
     }, Qt::QueuedConnection);
 
-    ModuleList::Instance()->init();
+    connect(PluginManager::Instance(), &PluginManager::pluginLoaded, this, [=](QString pluginName, ModuleBaseONB *module)
+    {
+        // the plugin may have connected already
+        if(moduleState(pluginName) == ModuleStarting)
+            setModuleState(pluginName, module ? ModuleRunning : ModuleFailed);
+    });
+
+    connect(hub, &Hub::enableChanged, this, [=](bool enabled)
+    {
+        if(enabled) XO_TRACE_INFO(Loader, "scheme started", QString("+%1 ms").arg(startupClock.elapsed()));
+    });
+
+    {
+        XO_PROFILE_SCOPE("ModuleList::init");
+        ModuleList::Instance()->init();
+    }
     parseApplicationsStartOptions();
+    warmPool->loadOptions(QApplication::applicationDirPath() + "/ModuleWarmPool");
 
     QStringList appPaths;
     QStringList pluginPaths;
@@ -131,9 +180,15 @@ void Loader::load(QString launchConfigPath)
 
         if(!info.exists()) { qDebug() << "Module doesn't exist" << appName; continue; }
 
-        if(startTypeByAppName[appName] == HOT) startApplication(appName);
+        if(startTypeByAppName[appName] == HOT)
+        {
+            XO_PROFILE_SCOPE("start application", appName);
+            startApplication(appName);
+        }
     }
 
+    refillWarmPool();
+
     for(auto pluginPath : pluginPaths)
     {
         QFileInfo info(pluginPath);
@@ -143,8 +198,16 @@ void Loader::load(QString launchConfigPath)
 #endif
 
         pluginList << pluginName;
+        pluginPathsByName[pluginName] = pluginPath;
+
+        // a plugin with configs is known without loading it, it's loaded when a scheme needs its classes
+        if(ConfigManager::moduleConfigsExist(pluginName))
+        {
+            XO_TRACE_DEBUG(Loader, "plugin registered", pluginName);
+            continue;
+        }
 
-        PluginManager::Instance()->load(pluginName, pluginPath);
+        loadPlugin(pluginName);
     }
 
     bool uiProvided = false;
@@ -152,6 +215,7 @@ void Loader::load(QString launchConfigPath)
     {
         QFileInfo info(corePluginPath);
         QString pluginName = info.completeBaseName();
+        XO_PROFILE_SCOPE("load core plugin", pluginName);
 
         auto plugin = QPluginLoader(corePluginPath).instance();
         if (plugin)
@@ -169,7 +233,11 @@ void Loader::load(QString launchConfigPath)
         }
     }
 
-    for(auto&& corePlugin : corePluginsByName) corePlugin->start();
+    for(auto it = corePluginsByName.begin(); it != corePluginsByName.end(); ++it)
+    {
+        XO_PROFILE_SCOPE("start core plugin", it.key());
+        it.value()->start();
+    }
 
     if (!uiProvided)
     {
@@ -180,26 +248,69 @@ void Loader::load(QString launchConfigPath)
 
 void Loader::startApplication(QString applicationName)
 {
+    if(pluginPathsByName.contains(applicationName)) { loadPlugin(applicationName); return; }
+
     if(!appPathsByName.contains(applicationName)) return;
 
-    if(processesByAppName.contains(applicationName)) return;
+    bool warm = warmPool->take(applicationName);
+
+    if(processesByAppName.contains(applicationName))
+    {
+        // a warm module is handed out as is, another one takes its place in the pool
+        if(warm) refillWarmPool();
+        return;
+    }
+
+    launchApplication(applicationName);
+}
+
+void Loader::launchApplication(QString applicationName)
+{
+    // crashed recently: the supervisor restarts it when the backoff is over
+    if(supervisor->isHeldBack(applicationName)) return;
 
     auto appPath = appPathsByName[applicationName];
 
-    auto process = new QProcess(this);
+    auto process = new ModuleProcess(applicationName, launchOptionsByAppName.value(applicationName), this);
     process->setWorkingDirectory(QFileInfo(appPath).dir().absolutePath());
     process->start(appPath, QStringList() << "-i" << "127.0.0.1" << "-p" << QString::number(server->getPort()));
 
     processesByAppName[applicationName] = process;
+    setModuleState(applicationName, ModuleStarting);
+
+    connect(process, &QProcess::started, this, [=]()
+    {
+        setModuleState(applicationName, ModuleRunning);
+        supervisor->started(applicationName);
+        monitor->watch(applicationName, process->processId());
+    });
+
+    // other errors are followed by finished()
+    connect(process, &QProcess::errorOccurred, process, [=](QProcess::ProcessError error)
+    {
+        if(error != QProcess::FailedToStart) return;
 
-    connect(process, &QProcess::errorOccurred, process, [=](QProcess::ProcessError) { processesByAppName.remove(applicationName); });
+        if(processesByAppName.value(applicationName) == process) processesByAppName.remove(applicationName);
+        setModuleState(applicationName, ModuleFailed);
+        process->deleteLater();
+    });
 
     connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), process, [=](int, QProcess::ExitStatus)
     {
+        process->deleteLater();
+
+        // killed on purpose, everything is cleaned up already
+        if(processesByAppName.value(applicationName) != process) return;
+
         processesByAppName.remove(applicationName);
+        monitor->unwatch(applicationName);
+        warmPool->forget(applicationName);
+        setModuleState(applicationName, ModuleStopped);
         hub->removeModule(applicationName);
         if(Core::Instance()->getScheme()->componentCountByModule.value(applicationName) > 0)
-            startApplication(applicationName);
+            supervisor->exited(applicationName);
+        else
+            supervisor->cancel(applicationName);
     });
 }
 
@@ -210,22 +321,129 @@ bool Loader::getApplicationStartType(QString applicationName)
 
 void Loader::killApplication(QString applicationName)
 {
+    if(pluginPathsByName.contains(applicationName))
+    {
+        if(unloadIdlePlugins) unloadPlugin(applicationName);
+        return;
+    }
+
     if(!appPathsByName.contains(applicationName)) return;
 
     if(startTypeByAppName[applicationName] == HOT) return;
 
+    // a running module stays connected and described while the pool has room for it
+    if(processesByAppName.contains(applicationName) && warmPool->park(applicationName)) return;
+
+    stopApplication(applicationName);
+}
+
+void Loader::stopApplication(QString applicationName)
+{
     moduleByName.remove(applicationName);
+    supervisor->cancel(applicationName);
+    warmPool->forget(applicationName);
+    monitor->unwatch(applicationName);
 
     if(!processesByAppName.contains(applicationName)) return;
 
-    auto process = processesByAppName[applicationName];
-    process->kill();
-    process->waitForFinished();
+    // not waiting for the process: its finished() handler only deletes it
+    auto process = processesByAppName.take(applicationName);
+    ModuleSupervisor::stop(process);
 
-    processesByAppName.remove(applicationName);
+    setModuleState(applicationName, ModuleStopped);
     hub->removeModule(applicationName);
 }
 
+void Loader::loadPlugin(QString pluginName)
+{
+    auto plugins = PluginManager::Instance();
+    if(plugins->isLoaded(pluginName) || plugins->isLoading(pluginName)) return;
+
+    setModuleState(pluginName, ModuleStarting);
+    plugins->loadAsync(pluginName, pluginPathsByName.value(pluginName));
+}
+
+void Loader::unloadPlugin(QString pluginName)
+{
+    if(!PluginManager::Instance()->isLoaded(pluginName)) return;
+
+    moduleByName.remove(pluginName);
+    hub->removeModule(pluginName);
+    PluginManager::Instance()->unload(pluginName);
+    setModuleState(pluginName, ModuleStopped);
+}
+
+void Loader::refillWarmPool()
+{
+    for(auto appName : warmPool->byRecentUse(applicationList))
+    {
+        if(warmPool->isFull()) break;
+
+        if(startTypeByAppName.value(appName, HOT) != COLD || processesByAppName.contains(appName)) continue;
+        if(!QFileInfo::exists(appPathsByName.value(appName))) continue;
+
+        launchApplication(appName);
+        if(processesByAppName.contains(appName)) warmPool->park(appName);
+    }
+}
+
+Loader::ModuleState Loader::moduleState(const QString &moduleName) const
+{
+    return stateByModuleName.value(moduleName, ModuleStopped);
+}
+
+bool Loader::areSchemeModulesReady() const
+{
+    auto scheme = Core::Instance()->getScheme();
+    if(!scheme) return true;
+
+    for(auto it = scheme->componentCountByModule.constBegin(); it != scheme->componentCountByModule.constEnd(); ++it)
+        if(it.value() > 0 && moduleState(it.key()) != ModuleReady) return false;
+
+    return true;
+}
+
+void Loader::setModuleState(const QString &moduleName, ModuleState state)
+{
+    auto it = stateByModuleName.find(moduleName);
+    if(it != stateByModuleName.end() && *it == state) return;
+
+    // transitional states are spans on the module's track of the startup trace
+    auto isSpan = [](ModuleState s) { return s == ModuleStarting || s == ModuleRunning || s == ModuleConnected; };
+    if(it != stateByModuleName.end() && isSpan(*it))
+        StartupProfiler::endAsync("module", stateName(*it), moduleName);
+    if(isSpan(state))
+        StartupProfiler::beginAsync("module", stateName(state), moduleName);
+    else
+        StartupProfiler::instant("module", QString("%1 %2").arg(moduleName).arg(stateName(state)));
+
+    stateByModuleName[moduleName] = state;
+    XO_TRACE_INFO(Loader, "module state", QString("+%1 ms %2 %3").arg(startupClock.elapsed()).arg(moduleName).arg(stateName(state)));
+    emit moduleStateChanged(moduleName, state);
+
+    // a scheme loaded later may wait for modules that were ready before, so this is emitted on every change
+    bool ready = areSchemeModulesReady();
+    if(ready && !schemeReady)
+        XO_TRACE_INFO(Loader, "scheme modules ready", QString("+%1 ms").arg(startupClock.elapsed()));
+    schemeReady = ready;
+
+    if(ready) emit schemeModulesReady();
+}
+
+const char *Loader::stateName(ModuleState state)
+{
+    switch(state)
+    {
+        case ModuleStopped: return "stopped";
+        case ModuleStarting: return "starting";
+        case ModuleRunning: return "running";
+        case ModuleConnected: return "connected";
+        case ModuleReady: return "ready";
+        case ModuleFailed: return "failed";
+    }
+    return "?";
+}
+
 bool Loader::applicationIsRunning(QString applicationName)
 {
     return processesByAppName.contains(applicationName);
@@ -234,6 +452,7 @@ bool Loader::applicationIsRunning(QString applicationName)
 void Loader::updateModuleStartType(QString moduleName, ModuleStartType type)
 {
     startTypeByAppName[moduleName] = type;
+    supervisor->resume(moduleName);
 
     switch(type)
     {
@@ -249,7 +468,9 @@ void Loader::updateModuleStartType(QString moduleName, ModuleStartType type)
 
     for(auto appName : startTypeByAppName.keys())
     {
-        stream << appName << " " << ((startTypeByAppName.value(appName) == ModuleStartType::HOT) ? 1 : 0) << endl;
+        stream << appName << " " << ((startTypeByAppName.value(appName) == ModuleStartType::HOT) ? 1 : 0);
+        for(auto token : launchOptionsByAppName.value(appName).toTokens()) stream << " " << token;
+        stream << endl;
     }
 }
 
@@ -258,19 +479,19 @@ void Loader::parseApplicationsStartOptions()
     QFile startOptionsFile(QApplication::applicationDirPath() + "/ModuleStartOptions");
     if(startOptionsFile.open(QIODevice::ReadOnly))
     {
-        QString contents = startOptionsFile.readAll();
-
-        QRegExp regExp("([^\\s]+)\\s(\\d+)(\\n)?");
-        regExp.setMinimal(true);
-        int position = 0;
-
-        while ((position = regExp.indexIn(contents, position)) != -1)
+        // <name> <start type> [launch options]
+        while (!startOptionsFile.atEnd())
         {
-            QString name = regExp.cap(1);
-            int value = regExp.cap(2).toInt();
+            QStringList tokens = QString(startOptionsFile.readLine()).simplified().split(' ');
+            if (tokens.size() < 2) continue;
+
+            QString name = tokens.takeFirst();
+            int value = tokens.takeFirst().toInt();
 
             startTypeByAppName[name] = value > 0 ? ModuleStartType::HOT : ModuleStartType::COLD;
-            position += regExp.matchedLength();
+
+            auto options = ModuleLaunchOptions::parse(tokens);
+            if (!options.isEmpty()) launchOptionsByAppName[name] = options;
         }
     }
 }
@@ -280,22 +501,52 @@ void Loader::refreshConfigsForModule(QString moduleName)
     QString configsPath = Core::FolderConfigs + moduleName;
     QDir configsDir(configsPath);
     configsDir.removeRecursively();
+    ConfigCatalog::Instance()->invalidate(moduleName);
+
+    ClassCache::remove(Core::FolderCache + moduleName);
 
     if(appPathsByName.contains(moduleName)) //является приложением
     {
         if(processesByAppName.contains(moduleName)) //приложение запущено
         {
-            ConfigManager::writeModuleConfig(moduleByName[moduleName]);
+            writeConfigWhenDescribed(moduleByName[moduleName]);
         }
         else //приложение не запущено
         {
+            supervisor->resume(moduleName);
             startApplication(moduleName); //дальше само разберется
         }
     }
     else //является плагином
     {
-        ConfigManager::writeModuleConfig(moduleByName[moduleName]);
+        if(moduleByName.contains(moduleName))
+            writeConfigWhenDescribed(moduleByName[moduleName]);
+        else
+            loadPlugin(moduleName); //без конфигов опишет все классы
+    }
+}
+
+void Loader::writeConfigWhenDescribed(ModuleProxyONB *module)
+{
+    if(!module) return;
+
+    module->requireAllClasses();
+    if(module->isReady())
+    {
+        ConfigManager::writeModuleConfig(module);
+        return;
     }
+
+    // the first ready of a new module writes the config anyway
+    QString name = module->name();
+    if(moduleConnectsModuleName.contains(name)) return;
+
+    moduleConnectsModuleName[name] = connect(module, &ModuleProxyONB::ready, this, [=]()
+    {
+        disconnect(moduleConnectsModuleName[name]);
+        moduleConnectsModuleName.remove(name);
+        ConfigManager::writeModuleConfig(module);
+    }, Qt::QueuedConnection);
 }
 
 QString Loader::getModulePath(QString moduleName, ModuleConfig::Type type)
@@ -5,10 +5,15 @@
 #include <QMap>
 #include <QObject>
 #include <QProcess>
+#include <QElapsedTimer>
 
 #include "Hub.h"
 #include "Server.h"
 #include "ModuleStartType.h"
+#include "ModuleSupervisor.h"
+#include "ModuleWarmPool.h"
+#include "ModuleProcess.h"
+#include "ModuleMonitor.h"
 #include "xoCorePlugin.h"
 #include "Module/ModuleProxyONB.h"
 
@@ -16,9 +21,28 @@ class XOCORESHARED_EXPORT Loader : public QObject
 {
     Q_OBJECT
 public:
+    //! startup progress of a module, logged with the time since load() as the startup timeline
+    enum ModuleState
+    {
+        ModuleStopped,
+        ModuleStarting,  //!< process launched or plugin library loading
+        ModuleRunning,   //!< process up or plugin instantiated
+        ModuleConnected, //!< connected to the server
+        ModuleReady,     //!< classes needed so far are described
+        ModuleFailed
+    };
+    Q_ENUM(ModuleState)
+
+    //! the scheme starts anyway if its modules are not ready after this time
+    static const int SchemeReadyTimeoutMs = 30000;
+
     explicit Loader(Server* server, Hub* hub, QObject *parent = nullptr);
     ~Loader();
 
+    ModuleState moduleState(const QString &moduleName) const;
+    //! every module having components in the current scheme is ready
+    bool areSchemeModulesReady() const;
+
     void load(QString launchConfigPath);
 
     bool getApplicationStartType(QString applicationName);
@@ -27,6 +51,14 @@ public:
     bool applicationIsRunning(QString applicationName);
     void updateModuleStartType(QString moduleName, ModuleStartType type);
     void refreshConfigsForModule(QString moduleName);
+    //! restart backoff, restart counters and uptime of module processes
+    ModuleSupervisor *getSupervisor() { return supervisor; }
+    //! COLD modules kept running while unused
+    ModuleWarmPool *getWarmPool() { return warmPool; }
+    //! CPU, memory, I/O and traffic of every module
+    ModuleMonitor *getMonitor() { return monitor; }
+    //! unload plugins when no component of the scheme uses them (off by default)
+    void setUnloadIdlePlugins(bool enabled) { unloadIdlePlugins = enabled; }
     QString getModulePath(QString moduleName, ModuleConfig::Type type);
     void parseApplicationsStartOptions();
 
@@ -36,17 +68,39 @@ public:
 
 signals:
     void configWritten(ModuleProxyONB* module);
+    void moduleStateChanged(QString moduleName, Loader::ModuleState state);
+    //! the last module the current scheme needs became ready
+    void schemeModulesReady();
 
 private:
     Server* server = nullptr;
     Hub* hub = nullptr;
+    ModuleSupervisor* supervisor = nullptr;
+    ModuleWarmPool* warmPool = nullptr;
+    ModuleMonitor* monitor = nullptr;
 
     QMap<QString, QString> appPathsByName;
+    QMap<QString, QString> pluginPathsByName;
+    bool unloadIdlePlugins = false;
     QSet<QString> names;
     QMap<QString, QProcess*> processesByAppName;
     QMap<QString, ModuleProxyONB*> moduleByName;
     QMap<QString, ModuleStartType> startTypeByAppName;
+    QMap<QString, ModuleLaunchOptions> launchOptionsByAppName;
     QMap<QString, QMetaObject::Connection> moduleConnectsModuleName;
+    QMap<QString, ModuleState> stateByModuleName;
+    QElapsedTimer startupClock;
+    bool schemeReady = false;
+
+    void setModuleState(const QString &moduleName, ModuleState state);
+    static const char *stateName(ModuleState state);
+
+    void writeConfigWhenDescribed(ModuleProxyONB *module);
+    void launchApplication(QString applicationName);
+    void stopApplication(QString applicationName);
+    void refillWarmPool();
+    void loadPlugin(QString pluginName);
+    void unloadPlugin(QString pluginName);
 
 };
 
@@ -0,0 +1,96 @@
+#include "ClassCache.h"
+#include "PersistenceWorker.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QDataStream>
+#include <QDateTime>
+#include <QCryptographicHash>
+
+const QString ClassCache::FileExtensionClassDot = ".class";
+
+namespace
+{
+    const quint32 Magic = 0x584F4343; // "XOCC"
+    const quint16 FormatVersion = 1;
+}
+
+ClassCache::ClassCache(const QString &directory, const QByteArray &buildHash) :
+    m_directory(directory),
+    m_buildHash(buildHash)
+{
+    if (!m_directory.isEmpty() && !m_directory.endsWith('/'))
+        m_directory += '/';
+}
+
+QString ClassCache::classPath(uint32_t classID) const
+{
+    return m_directory + QString::number(classID, 16).rightJustified(8, '0') + FileExtensionClassDot;
+}
+
+const ClassCache::Entry *ClassCache::find(uint32_t classID)
+{
+    if (!isEnabled())
+        return nullptr;
+
+    auto it = m_entries.constFind(classID);
+    if (it != m_entries.constEnd())
+        return &it.value();
+
+    if (m_looked.contains(classID))
+        return nullptr;
+    m_looked[classID] = true;
+
+    QFile file(classPath(classID));
+    if (!file.open(QIODevice::ReadOnly))
+        return nullptr;
+
+    QDataStream stream(&file);
+    quint32 magic = 0, cid = 0;
+    quint16 format = 0;
+    QByteArray hash;
+    Entry entry;
+    stream >> magic >> format >> hash >> cid;
+    if (magic != Magic || format != FormatVersion || hash != m_buildHash || cid != classID)
+        return nullptr;
+
+    stream >> entry.version >> entry.objectCount >> entry.fromClassInfo >> entry.transcript;
+    if (stream.status() != QDataStream::Ok)
+        return nullptr;
+
+    return &m_entries.insert(classID, entry).value();
+}
+
+void ClassCache::store(uint32_t classID, const Entry &entry)
+{
+    if (!isEnabled())
+        return;
+
+    m_entries[classID] = entry;
+
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream << Magic << FormatVersion << m_buildHash << static_cast<quint32>(classID);
+    stream << entry.version << entry.objectCount << entry.fromClassInfo << entry.transcript;
+
+    PersistenceWorker::Instance()->writeFile(classPath(classID), data);
+}
+
+QByteArray ClassCache::buildHash(const QString &binaryPath)
+{
+    QFileInfo info(binaryPath);
+    if (binaryPath.isEmpty() || !info.exists())
+        return QByteArray();
+
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    hash.addData(info.canonicalFilePath().toUtf8());
+    hash.addData(QByteArray::number(info.size()));
+    hash.addData(QByteArray::number(info.lastModified().toMSecsSinceEpoch()));
+    return hash.result();
+}
+
+void ClassCache::remove(const QString &directory)
+{
+    QDir(directory).removeRecursively();
+}
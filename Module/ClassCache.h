@@ -0,0 +1,49 @@
+#ifndef CLASSCACHE_H
+#define CLASSCACHE_H
+
+#include <QHash>
+#include <QString>
+#include <QByteArray>
+#include "xoCore_global.h"
+
+//! Persistent cache of class descriptions received from a module, one file per class:
+//! "<cache dir>/<classID>.class". A description is the transcript of the class handshake
+//! (service objects, object descriptions and meta values as ObjectBatch records) and is
+//! valid only for the module build it was received from, so a reconnecting module gets its
+//! classes and components described locally instead of object by object.
+class XOCORESHARED_EXPORT ClassCache
+{
+public:
+    static const QString FileExtensionClassDot;
+
+    struct Entry
+    {
+        quint16 version = 0;
+        quint8 objectCount = 0;
+        bool fromClassInfo = false; //!< recorded from class enumeration, not from a component instance
+        QByteArray transcript;
+    };
+
+    //! empty build hash disables the cache (e.g. for remote modules)
+    ClassCache(const QString &directory, const QByteArray &buildHash);
+
+    bool isEnabled() const { return !m_buildHash.isEmpty(); }
+
+    //! nullptr if the class was not cached for this build
+    const Entry *find(uint32_t classID);
+    void store(uint32_t classID, const Entry &entry);
+
+    //! cheap fingerprint of the module binary (path, size and modification time)
+    static QByteArray buildHash(const QString &binaryPath);
+    static void remove(const QString &directory);
+
+private:
+    QString m_directory;
+    QByteArray m_buildHash;
+    QHash<uint32_t, Entry> m_entries;
+    QHash<uint32_t, bool> m_looked; //!< classes already looked up on disk
+
+    QString classPath(uint32_t classID) const;
+};
+
+#endif // CLASSCACHE_H
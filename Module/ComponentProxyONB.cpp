@@ -1,6 +1,12 @@
 #include "ComponentProxyONB.h"
 
 #include <QJsonArray>
+#include <QMetaMethod>
+
+#include "Tracer.h"
+#include "ClassCache.h"
+#include "ONBExtensions.h"
+#include "ObjectObserver.h"
 
 ComponentProxyONB::ComponentProxyONB(unsigned short componentID, QObject *parent) : QObject(parent),
     m_componentInfoValid(false),
@@ -32,6 +38,13 @@ ComponentProxyONB::ComponentProxyONB(unsigned short componentID, QObject *parent
 
 ComponentProxyONB::~ComponentProxyONB()
 {
+    QSet<ObjectObserver*> observers;
+    for (const QList<ObjectObserver*> &list : m_observers)
+        for (ObjectObserver *observer : list)
+            observers << observer;
+    for (ObjectObserver *observer : observers)
+        observer->componentDestroyed(this);
+
     qDeleteAll(m_objects);
 }
 
@@ -81,11 +94,11 @@ QJsonObject ComponentProxyONB::settingsJson() const
 
 bool ComponentProxyONB::event(QEvent *event)
 {
-    if (event->type() == QEvent::DynamicPropertyChange && isReady())
+    if (event->type() == QEvent::DynamicPropertyChange && isReady() && m_mirrorProperties)
     {
         QDynamicPropertyChangeEvent *e = dynamic_cast<QDynamicPropertyChangeEvent*>(event);
         QString name = QString::fromUtf8(e->propertyName());
-        qDebug() << "[ComponentProxyONB] property changed from QObject" << name;
+        XO_TRACE_VERBOSE(Component, "property changed from QObject", name);
         ObjectProxy *obj = m_objectMap.value(name, nullptr);
         if (obj)
             obj->setValue(property(e->propertyName()));
@@ -156,7 +169,8 @@ void ComponentProxyONB::setInput(QString name, QVariant value)
         return;
     ObjectProxy *obj = m_objectMap[name];
     obj->setValue(value);
-    setProperty(name.toUtf8(), value);
+    if (m_mirrorProperties)
+        setProperty(name.toUtf8(), value);
 }
 
 QVariant ComponentProxyONB::getOutput(QString name)
@@ -166,7 +180,8 @@ QVariant ComponentProxyONB::getOutput(QString name)
     ObjectProxy *obj = m_objectMap[name];
     QVariant v = obj->value();
     // TODO: implement internal property setting without event firing!!
-    setProperty(name.toUtf8(), v);
+    if (m_mirrorProperties)
+        setProperty(name.toUtf8(), v);
     return v;
 }
 
@@ -177,7 +192,8 @@ QVariant ComponentProxyONB::getInput(QString name)
     ObjectProxy *obj = m_objectMap[name];
     QVariant v = obj->value();
     // TODO: implement internal property setting without event firing!!
-    setProperty(name.toUtf8(), v);
+    if (m_mirrorProperties)
+        setProperty(name.toUtf8(), v);
     return v;
 }
 
@@ -188,14 +204,181 @@ QVariant ComponentProxyONB::getSetting(QString name)
     ObjectProxy *obj = m_objectMap[name];
     QVariant v = obj->value();
     // TODO: implement internal property setting without event firing!!
-    setProperty(name.toUtf8(), v);
+    if (m_mirrorProperties)
+        setProperty(name.toUtf8(), v);
     return v;
 }
 
+void ComponentProxyONB::setInputs(QVariantMap values)
+{
+    // changed objects are collected by sendObject() and go out together
+    m_collectingBatch = true;
+    for (auto it = values.constBegin(); it != values.constEnd(); ++it)
+        setInput(it.key(), it.value());
+    m_collectingBatch = false;
+
+    sendBatch();
+}
+
+QVariantMap ComponentProxyONB::getOutputs(QStringList names)
+{
+    QVariantMap values;
+    for (const QString &name : names)
+    {
+        ObjectProxy *obj = m_objectMap.value(name, nullptr);
+        if (obj)
+            values[name] = obj->value();
+    }
+    return values;
+}
+
+void ComponentProxyONB::requestSnapshot(QStringList names)
+{
+    QByteArray ba;
+    if (names.isEmpty())
+    {
+        for (ObjectProxy *obj : getOutputs())
+            m_snapshotPending << static_cast<unsigned char>(obj->id);
+    }
+    else
+    {
+        for (const QString &name : names)
+        {
+            ObjectProxy *obj = m_objectMap.value(name, nullptr);
+            if (!obj)
+                continue;
+            m_snapshotPending << static_cast<unsigned char>(obj->id);
+            ba.append(static_cast<char>(obj->id));
+        }
+        if (ba.isEmpty())
+            return;
+    }
+
+    if (m_snapshotPending.isEmpty())
+    {
+        emit snapshotReceived();
+        return;
+    }
+
+    if (!m_batchSupported)
+    {
+        for (unsigned char oid : m_snapshotPending)
+            requestObject(oid);
+        return;
+    }
+
+    m_batchRequested += m_snapshotPending;
+    sendServiceMessage(svcRequestBatch, ba);
+    if (!m_batchConfirmed)
+        expectExtensionReply();
+}
+
+void ComponentProxyONB::sendBatch()
+{
+    QVector<unsigned char> queue;
+    queue.swap(m_batchQueue);
+    if (queue.size() == 1 || !m_batchSupported)
+    {
+        for (unsigned char oid : queue)
+            sendObject(oid);
+        return;
+    }
+
+    ObjectBatch batch;
+    for (unsigned char oid : queue)
+    {
+        ObjectProxy *obj = m_objects[oid];
+        // the batch carries whole values, the next delta must be based on this one
+        if (!batch.append(oid, obj->payload()))
+        {
+            sendObject(oid);
+            continue;
+        }
+        if (obj->m_deltaEncoder)
+            obj->m_deltaEncoder->reset();
+        m_batchSent << oid;
+    }
+
+    if (batch.isEmpty())
+        return;
+    sendServiceMessage(svcObjectBatch, batch.data());
+
+    // a peer without batches may drop them silently: until it has answered one,
+    // a request of the first value makes it prove it knows batches
+    if (!m_batchConfirmed && m_batchRequested.isEmpty())
+    {
+        unsigned char probe = *m_batchSent.constBegin();
+        m_batchRequested << probe;
+        sendServiceMessage(svcRequestBatch, probe);
+        expectExtensionReply();
+    }
+}
+
+void ComponentProxyONB::parseObjectBatch(const QByteArray &data)
+{
+    // a batch from the peer proves it knows batches, nothing has to be resent
+    m_batchConfirmed = true;
+    m_batchSent.clear();
+    m_batchRequested.clear();
+
+    QVector<ObjectBatch::Record> records;
+    if (!ObjectBatch::parse(data, records))
+        XO_TRACE_WARNING(Component, "damaged object batch", m_componentName.value(), records.size());
+
+    for (const ObjectBatch::Record &record : records)
+        parseMessage(record.oid, record.data);
+}
+
+void ComponentProxyONB::rejectBatches()
+{
+    // the peer doesn't take batches: resend and request object by object
+    XO_TRACE_WARNING(Component, "object batches not supported", m_componentName.value());
+    m_batchSupported = false;
+    QSet<unsigned char> sent;
+    sent.swap(m_batchSent);
+    for (unsigned char _oid : sent)
+        sendObject(_oid);
+    QSet<unsigned char> requested;
+    requested.swap(m_batchRequested);
+    for (unsigned char _oid : requested)
+        requestObject(_oid);
+}
+
 void ComponentProxyONB::sendObject(unsigned char oid)
 {
-    if (oid < m_objects.size() && m_objects[oid])
-        sendMessage(oid, m_objects[oid]->read());
+    if (oid >= m_objects.size() || !m_objects[oid])
+        return;
+
+    if (m_collectingBatch)
+    {
+        if (!m_batchQueue.contains(oid))
+            m_batchQueue << oid;
+        return;
+    }
+
+    ObjectProxy *obj = m_objects[oid];
+    QByteArray payload = obj->payload();
+    if (obj->m_deltaEncoder && m_deltaSupport == DeltaUnknown)
+    {
+        // a peer without deltas would drop them silently, it has to acknowledge them first
+        m_deltaSupport = DeltaProbing;
+        sendServiceMessage(svcDeltaObject, oid);
+        expectExtensionReply();
+    }
+    if (obj->m_deltaEncoder && m_deltaSupport == DeltaSupported)
+    {
+        QByteArray delta;
+        if (obj->m_deltaEncoder->encode(payload, delta))
+        {
+            QByteArray ba;
+            ba.append(static_cast<char>(oid));
+            ba.append('\0'); // reserved byte
+            ba.append(delta);
+            sendServiceMessage(svcDeltaObject, ba);
+            return;
+        }
+    }
+    sendMessage(oid, payload);
 }
 
 void ComponentProxyONB::sendTimedObject(unsigned char oid)
@@ -209,7 +392,10 @@ void ComponentProxyONB::sendTimedObject(unsigned char oid)
         ba.append(reinterpret_cast<const char*>(&oid), sizeof(unsigned char));
         ba.append('\0'); // reserved byte
         ba.append(reinterpret_cast<const char*>(&obj->m_timestamp), sizeof(uint32_t));
-        obj->read(ba);
+        ba.append(obj->payload());
+        // timed values go whole, the next delta must not be based on an older value
+        if (obj->m_deltaEncoder)
+            obj->m_deltaEncoder->reset();
         sendServiceMessage(svcTimedObject, ba);
     }
 }
@@ -223,7 +409,7 @@ void ComponentProxyONB::sendObject(QString name)
     //    if (value.isValid())
     //        obj->setValue(value);
 
-    sendMessage(obj->id, obj->read());
+    sendObject(static_cast<unsigned char>(obj->id));
 }
 
 void ComponentProxyONB::requestObject(unsigned char oid)
@@ -261,7 +447,7 @@ void ComponentProxyONB::subscribe(QString name, int period_ms)
             QByteArray ba;
             ba.append(reinterpret_cast<const char*>(&period_ms), sizeof(int));
             ba.append(obj->id);
-            qDebug() << "[ComponentProxyONB] subscribe to" << obj->name() << "(" << period_ms << "ms" << (obj->m_needTimestamp? "with timestamp)" : ")");
+            XO_TRACE_DEBUG(Component, obj->m_needTimestamp ? "subscribe with timestamp" : "subscribe", obj->name(), period_ms);
             if (obj->m_needTimestamp)
                 sendServiceMessage(svcTimedRequest, ba);
             else
@@ -301,6 +487,82 @@ void ComponentProxyONB::unsubscribeAll()
     sendServiceMessage(svcUnsubscribe);
 }
 
+void ComponentProxyONB::requestDelta(QString name, bool enabled)
+{
+    if (!m_objectMap.contains(name))
+        return;
+    ObjectProxy *obj = m_objectMap[name];
+    if (obj->type() != ObjectBase::Common && obj->type() != ObjectBase::Image)
+        return;
+    if (obj->m_deltaRequested == enabled)
+        return;
+
+    obj->m_deltaRequested = enabled;
+    obj->m_deltaReceivedStats = DeltaCodec::Stats();
+
+    QByteArray ba;
+    ba.append(static_cast<char>(obj->id));
+    ba.append(static_cast<char>(enabled));
+    // a peer without deltas answers svcFail or just keeps sending whole values, both are fine
+    sendServiceMessage(svcRequestDelta, ba);
+}
+
+void ComponentProxyONB::parseDeltaObject(const QByteArray &data)
+{
+    if (data.size() == 1)
+    {
+        // the answer to our probe, or the peer probing us: it knows deltas either way
+        bool probedByPeer = m_deltaSupport != DeltaProbing;
+        m_deltaSupport = DeltaSupported;
+        if (probedByPeer)
+            sendServiceMessage(svcDeltaObject, data);
+        return;
+    }
+
+    if (data.size() < 2 + DeltaCodec::HeaderSize)
+    {
+        XO_TRACE_WARNING(Component, "damaged delta object", m_componentName.value(), data.size());
+        return;
+    }
+
+    unsigned char _oid = data[0];
+    if (_oid < m_objects.size() && m_objects[_oid])
+    {
+        ObjectProxy *obj = m_objects[_oid];
+        QByteArray value;
+        if (DeltaCodec::decode(obj->payload(), data, 2, value))
+        {
+            obj->m_deltaReceivedStats.add(value.size(), data.size(), false);
+            parseMessage(_oid, value);
+        }
+        else
+        {
+            requestObject(_oid); // out of sync, the whole value resynchronizes
+        }
+    }
+}
+
+void ComponentProxyONB::rejectDeltaMode()
+{
+    // the peer doesn't take deltas: whole values from now on
+    XO_TRACE_WARNING(Component, "delta objects not supported", m_componentName.value());
+    m_deltaSupport = DeltaUnsupported;
+    for (ObjectProxy *obj: m_objects)
+    {
+        if (!obj || !obj->deltaMode())
+            continue;
+        obj->setDeltaMode(false);
+        // a delta sent before the peer refused it left the peer on the old value
+        sendObject(static_cast<unsigned char>(obj->id));
+    }
+}
+
+void ComponentProxyONB::countWholeValue(unsigned char oid, int size)
+{
+    if (oid < m_objects.size() && m_objects[oid] && m_objects[oid]->m_deltaRequested)
+        m_objects[oid]->m_deltaReceivedStats.add(size, size, true);
+}
+
 void ComponentProxyONB::setComponentName(QString name)
 {
     //sendServiceMessage(svcName, name.toUtf8());
@@ -308,6 +570,21 @@ void ComponentProxyONB::setComponentName(QString name)
     emit infoChanged();
 }
 
+void ComponentProxyONB::setMirrorProperties(bool enabled)
+{
+    if (m_mirrorProperties == enabled)
+        return;
+
+    m_mirrorProperties = enabled;
+
+    for (auto obj : m_objects)
+    {
+        if (!obj)
+            continue;
+        setProperty(obj->name().toUtf8(), enabled ? obj->value() : QVariant());
+    }
+}
+
 void ComponentProxyONB::extractPrototype(ComponentProxyONB *proto) const
 {
     //    proto->m_componentName = "";
@@ -344,6 +621,24 @@ void ComponentProxyONB::requestInfo()
     sendServiceMessage(svcName);
     sendServiceMessage(svcRequestAllInfo);
 }
+
+void ComponentProxyONB::requestName()
+{
+    sendServiceMessage(m_className.description().id);
+    sendServiceMessage(svcName);
+}
+
+QImage ComponentProxyONB::icon() const
+{
+    // decode once per received icon
+    const QByteArray &data = m_iconData;
+    if (data.constData() != m_iconSource.constData() || data.size() != m_iconSource.size())
+    {
+        m_iconSource = data;
+        m_icon = QImage::fromData(data);
+    }
+    return m_icon;
+}
 //---------------------------------------------------------
 
 void ComponentProxyONB::receiveData(const ONBPacket &packet)
@@ -359,11 +654,18 @@ void ComponentProxyONB::receiveData(const ONBPacket &packet)
             parseServiceMessage(oid, packet.data());
     }
     else
+    {
+        countWholeValue(oid, packet.data().size());
         parseMessage(oid, packet.data());
+    }
 }
 
 void ComponentProxyONB::parseServiceMessage(unsigned char oid, const QByteArray &data)
 {
+    if (!m_replaying && !m_descriptionComplete &&
+        (oid < m_svcObjects.size() || oid == svcObjectInfo || (oid >= svcObjectMinimum && oid < svcTimedObject)))
+        m_transcript.append(oid, data);
+
     if (oid < m_svcObjects.size())
     {
         m_svcObjects[oid]->write(data);
@@ -381,41 +683,75 @@ void ComponentProxyONB::parseServiceMessage(unsigned char oid, const QByteArray
             }
             oldCount = 0;
         }
+        if (!oldCount)
+        {
+            m_validObjects = 0;
+            m_pendingMeta = 0;
+        }
         m_objectsInfoValid = false;
+        m_descriptionComplete = false;
         m_objects.resize(m_objectCount);
         m_objBuffers.resize(m_objectCount);
         for (int _oid=oldCount; _oid<m_objectCount; _oid++)
-        {
             m_objects[_oid] = nullptr;
-            sendServiceMessage(svcObjectInfo, _oid);
-        }
 
-        //sendServiceMessage(svcRequestObjInfo);
+        // a replayed transcript carries the descriptions itself
+        if (oldCount < m_objectCount && !m_replaying && !replayCachedDescription())
+            requestObjectsInfo(oldCount);
+    }
+    else if (oid == svcRequestObjInfo)
+    {
+        m_describePending = false;
+        parseObjectInfoBatch(data);
     }
     else if (oid == svcObjectInfo)
     {
+        // older peers answer the bulk describe object by object
+        m_describePending = false;
         prepareObject(data);
         unsigned char _oid = data[0];
-        QByteArray ba;
-        ba.append(_oid);
-//        sendServiceMessage(svcObjectExtInfo, ba);
-        unsigned short ef = m_objects[_oid]->description().extFlags;
-        for (int i=0; i<16; i++)
+        // inside a bulk reply the meta values follow the description
+        if (!m_inBatch && _oid < m_objects.size() && m_objects[_oid])
         {
-            if (ef & (1<<i))
-                sendServiceMessage(svcObjectMinimum + i, ba);
+            QByteArray ba;
+            ba.append(_oid);
+            unsigned short ef = m_objects[_oid]->description().extFlags;
+            for (int i=0; i<16; i++)
+            {
+                if (ef & (1<<i))
+                {
+                    m_pendingMeta++;
+                    sendServiceMessage(svcObjectMinimum + i, ba);
+                }
+            }
         }
     }
     else if (oid >= svcObjectMinimum && oid < svcTimedObject)
     {
+        if (!m_inBatch && m_pendingMeta > 0)
+            m_pendingMeta--;
+
         unsigned char _oid = data[0];
         if (_oid < m_objectCount && m_objects[_oid])
         {
             ObjectProxy *obj = m_objects[_oid];
             unsigned char metavalue = oid - svcObjectInfo;
-            bool changed = obj->writeMeta(data.mid(1), static_cast<ObjectBase::MetaValue>(metavalue));
-            if (changed)
+            if (obj->writeMeta(data.mid(1), static_cast<ObjectBase::MetaValue>(metavalue)))
+                m_metaChanged = true;
+        }
+
+        // one notification when the last requested value arrives, not one per value
+        if (!m_pendingMeta)
+        {
+            if (m_metaChanged)
+            {
+                m_metaChanged = false;
                 checkForReady();
+            }
+            else
+            {
+                checkDescriptionComplete();
+            }
         }
     }
     else if (oid == svcTimedObject)
@@ -426,10 +762,18 @@ void ComponentProxyONB::parseServiceMessage(unsigned char oid, const QByteArray
         {
             ObjectProxy *obj = m_objects[_oid];
             obj->m_timestamp = timestamp;
-            // TODO: get rid of copying
-            parseMessage(_oid, data.mid(6));
+            countWholeValue(_oid, data.size() - 6);
+            parseMessage(_oid, data, 6);
         }
     }
+    else if (oid == svcObjectBatch)
+    {
+        parseObjectBatch(data);
+    }
+    else if (oid == svcDeltaObject)
+    {
+        parseDeltaObject(data);
+    }
     else if (oid == svcFail)
     {
         if (data.size())
@@ -443,8 +787,9 @@ void ComponentProxyONB::parseServiceMessage(unsigned char oid, const QByteArray
                 break;
 
             case svcRequestObjInfo:
-                for (unsigned char idx=0; idx<m_objectCount; idx++)
-                    sendServiceMessage(svcObjectInfo, idx);
+                // no bulk describe on the peer: ask object by object
+                m_describePending = false;
+                requestMissingObjectsInfo();
                 break;
 
             case svcAutoRequest:
@@ -452,12 +797,44 @@ void ComponentProxyONB::parseServiceMessage(unsigned char oid, const QByteArray
                 qDebug() << "[ComponentProxyONB] subscribe failed";
                 break;
 
+            case svcDeltaObject:
+                rejectDeltaMode();
+                break;
+
+            case svcRequestDelta:
+                // the publisher keeps sending whole values, nothing to compress
+                XO_TRACE_WARNING(Component, "delta outputs not supported", m_componentName.value());
+                for (ObjectProxy *obj: m_objects)
+                    if (obj)
+                        obj->m_deltaRequested = false;
+                break;
+
+            case svcObjectBatch:
+            case svcRequestBatch:
+                rejectBatches();
+                break;
+
             case svcTimedRequest:
                 //! @TODO: create timer and set flag needTimestamp
                 qDebug() << "[ComponentProxyONB] subscribe with timestamp failed";
                 break;
 
-            default:;
+            default:
+                if (failedOid >= svcObjectMinimum && failedOid < svcTimedObject && m_pendingMeta > 0)
+                {
+                    if (!--m_pendingMeta)
+                    {
+                        if (m_metaChanged)
+                        {
+                            m_metaChanged = false;
+                            checkForReady();
+                        }
+                        else
+                        {
+                            checkDescriptionComplete();
+                        }
+                    }
+                }
             }
 
             //! @TODO: if service object doesn't exist, just check it
@@ -467,7 +844,7 @@ void ComponentProxyONB::parseServiceMessage(unsigned char oid, const QByteArray
     }
 }
 
-void ComponentProxyONB::parseMessage(unsigned char oid, const QByteArray &data)
+void ComponentProxyONB::parseMessage(unsigned char oid, const QByteArray &data, int offset)
 {
     if (oid < m_objects.size())
     {
@@ -475,19 +852,62 @@ void ComponentProxyONB::parseMessage(unsigned char oid, const QByteArray &data)
         if (!obj)
             return;
 
-        obj->write(data);
+        if (obj->type() == ObjectBase::Image)
+        {
+            // images are kept as received and decoded only if someone looks at the pixels,
+            // comparing them with the previous frame would cost as much as a copy
+            obj->setFrame(ImageFrame(data, offset));
+            obj->m_changed = true;
+            emit obj->received();
+            emit obj->valueChanged();
+        }
+        else
+        {
+            obj->write(offset ? data.mid(offset) : data);
+        }
+
+        // the name-based signals are for scripts, nobody pays for them if nobody listens
+        static const QMetaMethod receivedSignal = QMetaMethod::fromSignal(&ComponentProxyONB::objectReceived);
+        static const QMetaMethod changedSignal = QMetaMethod::fromSignal(&ComponentProxyONB::objectChanged);
 
-        emit objectReceived(obj->name());
+        if (isSignalConnected(receivedSignal))
+            emit objectReceived(obj->name());
 
         if (obj->m_changed)
         {
             obj->m_changed = false;
             //            qDebug() << "object changed" << obj->name() << " to " << obj->value();
-            emit objectChanged(obj->name());
+            if (isSignalConnected(changedSignal))
+                emit objectChanged(obj->name());
+
+            auto observers = m_observers.constFind(oid);
+            if (observers != m_observers.constEnd())
+                for (ObjectObserver *observer : *observers)
+                    observer->notify(ObjectObserver::key(m_id, oid));
         }
+
+        if (m_snapshotPending.remove(oid) && m_snapshotPending.isEmpty())
+            emit snapshotReceived();
     }
 }
 
+void ComponentProxyONB::addObserver(unsigned char oid, ObjectObserver *observer)
+{
+    QList<ObjectObserver*> &observers = m_observers[oid];
+    if (!observers.contains(observer))
+        observers << observer;
+}
+
+void ComponentProxyONB::removeObserver(unsigned char oid, ObjectObserver *observer)
+{
+    auto it = m_observers.find(oid);
+    if (it == m_observers.end())
+        return;
+    it->removeOne(observer);
+    if (it->isEmpty())
+        m_observers.erase(it);
+}
+
 void ComponentProxyONB::sendServiceMessage(unsigned char oid, const QByteArray &data)
 {
     ONBHeader hdr;
@@ -582,6 +1002,8 @@ void ComponentProxyONB::prepareObject(const ObjectDescription &desc)
     ObjectProxy *obj = m_objects.value(oid, nullptr);
     if (obj)
     {
+        if (obj->isValid())
+            m_validObjects--;
         m_objectMap.remove(obj->name());
 //        obj->setDescription(desc);
         delete obj; //! @warning this is OPASNO!! or not, need to test
@@ -592,13 +1014,19 @@ void ComponentProxyONB::prepareObject(const ObjectDescription &desc)
 //    }
 
     if (!obj)
+    {
         qDebug("PIZDEC koro4e blya: no object created for given type");
+        m_objects[oid] = nullptr;
+        return;
+    }
 
     m_objects[oid] = obj;
     m_objectMap[desc.name] = obj;
+    if (obj->isValid())
+        m_validObjects++;
 
     // TODO: new thing, need testing!!!
-    if (!property(obj->name().toUtf8()).isValid())
+    if (m_mirrorProperties && !property(obj->name().toUtf8()).isValid())
         setProperty(obj->name().toUtf8(), QVariant(static_cast<QVariant::Type>(obj->type())));
 
     // check if all object info is received
@@ -607,17 +1035,13 @@ void ComponentProxyONB::prepareObject(const ObjectDescription &desc)
 
 void ComponentProxyONB::checkForReady()
 {
-    bool flag = true;
-    for (auto& objectInfo : m_objects)
+    if (m_inBatch)
     {
-        if (!objectInfo || !objectInfo->isValid())
-        {
-            flag = false;
-            break;
-        }
+        m_readyCheckDeferred = true;
+        return;
     }
 
-    m_objectsInfoValid = flag;
+    m_objectsInfoValid = m_validObjects == m_objects.size();
 
     if (m_objectsInfoValid)
     {
@@ -628,9 +1052,131 @@ void ComponentProxyONB::checkForReady()
         }
         else
         {
-            qDebug() << "[ComponentProxyONB] info changed";
+            XO_TRACE_DEBUG(Component, "info changed", m_componentName.value());
             emit infoChanged();
         }
     }
+
+    checkDescriptionComplete();
+}
+
+void ComponentProxyONB::checkDescriptionComplete()
+{
+    if (m_descriptionComplete || m_inBatch || !m_objectsInfoValid || m_pendingMeta)
+        return;
+
+    m_descriptionComplete = true;
+    emit descriptionComplete();
+}
+
+void ComponentProxyONB::requestObjectsInfo(int fromOid)
+{
+    if (fromOid == 0)
+    {
+        // peers without bulk describe answer svcFail and get the per-object requests then,
+        // older peers ignore the flags and answer with separate svcObjectInfo
+        sendServiceMessage(svcRequestObjInfo, static_cast<unsigned char>(ObjectBatch::DescribeWithMeta));
+        m_describePending = true;
+        expectExtensionReply();
+        return;
+    }
+
+    for (int _oid=fromOid; _oid<m_objectCount; _oid++)
+        sendServiceMessage(svcObjectInfo, _oid);
+}
+
+void ComponentProxyONB::requestMissingObjectsInfo()
+{
+    for (unsigned char idx=0; idx<m_objectCount; idx++)
+        if (idx < m_objects.size() && !m_objects[idx])
+            sendServiceMessage(svcObjectInfo, idx);
+}
+
+void ComponentProxyONB::expectExtensionReply()
+{
+    if (!m_extensionTimer)
+    {
+        m_extensionTimer = new QTimer(this);
+        m_extensionTimer->setSingleShot(true);
+        connect(m_extensionTimer, &QTimer::timeout, this, &ComponentProxyONB::extensionReplyTimeout);
+    }
+    m_extensionTimer->start(ExtensionReplyTimeoutMs);
 }
 
+void ComponentProxyONB::extensionReplyTimeout()
+{
+    if (m_deltaSupport == DeltaProbing)
+        rejectDeltaMode();
+
+    if (m_batchSupported && !m_batchConfirmed && !m_batchRequested.isEmpty())
+        rejectBatches();
+
+    if (m_describePending)
+    {
+        // the peer dropped the bulk describe silently
+        XO_TRACE_WARNING(Component, "bulk describe not answered", m_componentName.value());
+        m_describePending = false;
+        requestMissingObjectsInfo();
+    }
+}
+
+void ComponentProxyONB::parseObjectInfoBatch(const QByteArray &data)
+{
+    QVector<ObjectBatch::Record> records;
+    if (!ObjectBatch::parse(data, records))
+        XO_TRACE_WARNING(Component, "damaged object info batch", m_componentName.value(), records.size());
+
+    m_inBatch = true;
+    for (const ObjectBatch::Record &record : records)
+    {
+        // only descriptions and meta values are expected here
+        if (record.oid == svcObjectInfo || (record.oid >= svcObjectMinimum && record.oid < svcTimedObject))
+            parseServiceMessage(record.oid, record.data);
+    }
+    m_inBatch = false;
+
+    // objects missing from the reply are requested one by one
+    for (unsigned char idx=0; idx<m_objectCount; idx++)
+        if (!m_objects[idx])
+            sendServiceMessage(svcObjectInfo, idx);
+
+    if (m_readyCheckDeferred || m_metaChanged)
+    {
+        m_readyCheckDeferred = false;
+        m_metaChanged = false;
+        checkForReady();
+    }
+}
+
+bool ComponentProxyONB::replayCachedDescription()
+{
+    const ClassCache::Entry *entry = m_classCache ? m_classCache->find(m_classID) : nullptr;
+    if (!entry || entry->version != m_version || entry->objectCount != m_objectCount)
+        return false;
+
+    XO_TRACE_DEBUG(Component, "description from class cache", m_componentName.value(), m_classID);
+    return replayDescription(entry->transcript, false);
+}
+
+bool ComponentProxyONB::replayDescription(const QByteArray &transcript, bool withServiceObjects)
+{
+    QVector<ObjectBatch::Record> records;
+    if (!ObjectBatch::parse(transcript, records))
+        return false;
+
+    bool replaying = m_replaying;
+    m_replaying = true;
+    m_inBatch = true;
+    for (const ObjectBatch::Record &record : records)
+    {
+        if (withServiceObjects || record.oid == svcObjectInfo || (record.oid >= svcObjectMinimum && record.oid < svcTimedObject))
+            parseServiceMessage(record.oid, record.data);
+    }
+    m_inBatch = false;
+    m_replaying = replaying;
+
+    m_readyCheckDeferred = false;
+    m_metaChanged = false;
+    checkForReady();
+    return m_objectsInfoValid;
+}
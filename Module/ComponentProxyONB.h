@@ -2,16 +2,22 @@
 #define COMPONENTPROXYONB_H
 
 #include <QObject>
+#include <QSet>
 #include <QVector>
 #include <QImage>
+#include <QTimer>
 #include <QDynamicPropertyChangeEvent>
 #include "ObjectProxy.h"
+#include "ObjectBatch.h"
 #include "Protocol/xoTypes.h"
 #include "Protocol/xoImage.h"
 #include "Protocol/ONBPacket.h"
 #include <QDebug>
 #include "xoCore_global.h"
 
+class ClassCache;
+class ObjectObserver;
+
 enum ONBChannelType
 {
     Settings,
@@ -33,6 +39,7 @@ public:
     Q_PROPERTY(int burnCount READ burnCount)
     Q_PROPERTY(uchar busType READ busType)
     Q_PROPERTY(QString type READ componentType)
+    Q_PROPERTY(bool mirrorProperties READ mirrorProperties WRITE setMirrorProperties)
 
     explicit ComponentProxyONB(unsigned short componentID, QObject *parent = nullptr);
     virtual ~ComponentProxyONB();
@@ -56,6 +63,13 @@ public:
     Q_INVOKABLE QVariant getInput(QString name);
     Q_INVOKABLE QVariant getSetting(QString name);
 
+    //! set several inputs and send the changed ones in one packet
+    Q_INVOKABLE void setInputs(QVariantMap values);
+    //! last buffered values of given outputs by name
+    Q_INVOKABLE QVariantMap getOutputs(QStringList names);
+    //! request given objects (all volatile outputs if none) in one round-trip, snapshotReceived() follows
+    Q_INVOKABLE void requestSnapshot(QStringList names = QStringList());
+
     //! send object to remote component.
     void sendObject(QString name);
     //! request object from remote component.
@@ -64,6 +78,8 @@ public:
     void subscribe(QString name, int period_ms=-1); // auto-period by default
     void unsubscribe(QString name);
     void unsubscribeAll();
+    //! ask the peer to send the output as block-level deltas, the core rebuilds the whole values
+    void requestDelta(QString name, bool enabled);
 
     unsigned short id() const { return m_id; }
 
@@ -81,13 +97,20 @@ public:
     BusType busType() const {return static_cast<BusType>(m_busType.value());}
     QString componentType() const {return m_className;}
     const QByteArray &iconData() const {return m_iconData;}
-    QImage icon() const {return QImage::fromData(m_iconData);}
+    QImage icon() const;
 
     int objectCount() const {return m_objectCount;}
     const ObjectProxy *object(unsigned char oid) const {if (oid < m_objects.size()) return m_objects[oid]; return nullptr;}
     ObjectProxy *object(QString name) const {return m_objectMap.value(name, nullptr);}
 
     bool isReady() const {return m_ready;}
+    //! all object descriptions and requested meta values are received
+    bool isDescriptionComplete() const {return m_descriptionComplete;}
+    //! handshake records the description was built from, see ClassCache
+    const QByteArray &descriptionTranscript() const {return m_transcript.data();}
+    //! rebuild the description from a transcript without asking the remote side
+    bool replayDescription(const QByteArray &transcript, bool withServiceObjects);
+    void setClassCache(ClassCache *cache) {m_classCache = cache;}
     QJsonObject getInfoJson() const;
     QJsonObject settingsJson() const;
     void setComponentName(QString name);
@@ -96,14 +119,25 @@ public:
 
     bool isFactory() const { return m_isFactory; }
 
+    //! mirror object values into dynamic properties of the component (off by default).
+    //! Needed only for property-style access like "comp.input = 1" from scripts.
+    bool mirrorProperties() const { return m_mirrorProperties; }
+    void setMirrorProperties(bool enabled);
+
 signals:
     void ready();
     void infoChanged();
+    void descriptionComplete();
+    //! emitted per packet: prefer ObjectObserver for anything that follows the data rate
     void objectReceived(QString name);
     void objectChanged(QString name);
+    //! every object of the last requestSnapshot() is received
+    void snapshotReceived();
 
 public slots:
     void requestInfo();
+    //! request only class name and name, enough to list the class before its details are needed
+    void requestName();
 
 
 private:
@@ -116,6 +150,43 @@ private:
     bool m_objectsInfoValid;
     bool m_ready;
     bool m_isFactory = true;
+    bool m_mirrorProperties = false;
+
+    //! handshake state, readiness is tracked by counters instead of scanning all objects
+    int m_validObjects = 0;        //!< objects having a valid description
+    int m_pendingMeta = 0;         //!< meta values requested one by one and not received yet
+    bool m_metaChanged = false;
+    bool m_inBatch = false;        //!< parsing a bulk reply: meta is included, notify once at the end
+    bool m_readyCheckDeferred = false;
+    bool m_descriptionComplete = false;
+    bool m_replaying = false;
+    ObjectBatch m_transcript;
+    ClassCache *m_classCache = nullptr;
+
+    //! batch exchange, falls back to one packet per object if the peer answers svcFail
+    bool m_batchSupported = true;
+    bool m_batchConfirmed = false;        //!< the peer has sent a batch
+    bool m_collectingBatch = false;
+    QVector<unsigned char> m_batchQueue;  //!< objects to send when collecting ends
+    QSet<unsigned char> m_batchSent;      //!< sent in batches before the peer confirmed support
+    QSet<unsigned char> m_batchRequested;
+    QSet<unsigned char> m_snapshotPending;
+    void sendBatch();
+    void parseObjectBatch(const QByteArray &data);
+    void rejectBatches();
+
+    //! deltas go out only after the peer acknowledged the probe, whole values are sent meanwhile
+    enum DeltaSupport { DeltaUnknown, DeltaProbing, DeltaSupported, DeltaUnsupported };
+    DeltaSupport m_deltaSupport = DeltaUnknown;
+    void parseDeltaObject(const QByteArray &data);
+    void rejectDeltaMode();
+    //! inbound compression of outputs the peer was asked to send as deltas
+    void countWholeValue(unsigned char oid, int size);
+
+    QHash<unsigned char, QList<ObjectObserver*>> m_observers;
+    friend class ObjectObserver;
+    void addObserver(unsigned char oid, ObjectObserver *observer);
+    void removeObserver(unsigned char oid, ObjectObserver *observer);
 
     //! unique component id (aka address)
     unsigned short m_id;
@@ -133,6 +204,8 @@ private:
     xoUInt8 m_busType;
     xoString m_className;
     xoByteArray m_iconData;
+    mutable QByteArray m_iconSource; //!< icon data the cached icon was decoded from
+    mutable QImage m_icon;
 
     //! create bindings for service objects
     unsigned char bindSvcObject(ObjectBase &obj);
@@ -143,9 +216,26 @@ private:
     void prepareObject(const ObjectDescription &desc);
     //! check if ObjectInfo description read completed (and emit the signal)
     void checkForReady();
+    //! request descriptions of objects starting from given one, in bulk if the peer supports it
+    void requestObjectsInfo(int fromOid);
+    //! per-object describe of the objects not described yet
+    void requestMissingObjectsInfo();
+
+    //! a peer may drop an extension request without svcFail, the request is given up on then
+    static const int ExtensionReplyTimeoutMs = 1000;
+    QTimer *m_extensionTimer = nullptr;
+    bool m_describePending = false; //!< bulk describe sent and not answered yet
+    void expectExtensionReply();
+    void extensionReplyTimeout();
+    //! bulk reply to svcRequestObjInfo: descriptions with all meta values in one packet
+    void parseObjectInfoBatch(const QByteArray &data);
+    //! describe objects from the class cache if it has this class and version
+    bool replayCachedDescription();
+    void checkDescriptionComplete();
 
     void parseServiceMessage(unsigned char oid, const QByteArray &data);
-    void parseMessage(unsigned char oid, const QByteArray &data);
+    //! offset is where the object data starts in a packet with a header (e.g. timed object)
+    void parseMessage(unsigned char oid, const QByteArray &data, int offset = 0);
     void sendServiceMessage(unsigned char oid, const QByteArray &data = QByteArray());
     void sendServiceMessage(unsigned char oid, unsigned char data);
     void sendMessage(unsigned char oid, const QByteArray &data = QByteArray());
@@ -0,0 +1,108 @@
+#include "DeltaCodec.h"
+
+#include <cstring>
+
+DeltaCodec::DeltaCodec(int blockSize) :
+    m_blockSize(qBound(16, blockSize, 0xFFFF))
+{
+}
+
+void DeltaCodec::reset()
+{
+    m_base.clear();
+    m_sinceKeyframe = 0;
+}
+
+void DeltaCodec::keyframe(const QByteArray &value)
+{
+    m_base = value;
+    m_sinceKeyframe = 0;
+    m_stats.keyframes++;
+    m_stats.sentBytes += static_cast<quint64>(value.size());
+}
+
+bool DeltaCodec::encode(const QByteArray &value, QByteArray &delta)
+{
+    m_stats.frames++;
+    m_stats.rawBytes += static_cast<quint64>(value.size());
+
+    if (m_base.isEmpty() || m_base.size() != value.size() || ++m_sinceKeyframe >= KeyframeInterval)
+    {
+        keyframe(value);
+        return false;
+    }
+
+    const int size = value.size();
+    const int blocks = (size + m_blockSize - 1) / m_blockSize;
+    const int bitmapSize = (blocks + 7) / 8;
+
+    delta.clear();
+    delta.reserve(HeaderSize + bitmapSize + size / 4);
+    quint32 totalSize = static_cast<quint32>(size);
+    quint16 blockSize = static_cast<quint16>(m_blockSize);
+    delta.append(reinterpret_cast<const char*>(&totalSize), sizeof(totalSize));
+    delta.append(reinterpret_cast<const char*>(&blockSize), sizeof(blockSize));
+    delta.append(QByteArray(bitmapSize, '\0'));
+
+    const char *src = value.constData();
+    const char *old = m_base.constData();
+    for (int i=0; i<blocks; i++)
+    {
+        int pos = i * m_blockSize;
+        int len = qMin(m_blockSize, size - pos);
+        if (memcmp(src + pos, old + pos, static_cast<size_t>(len)) != 0)
+        {
+            delta[HeaderSize + i / 8] = static_cast<char>(delta[HeaderSize + i / 8] | (1 << (i % 8)));
+            delta.append(src + pos, len);
+        }
+
+        // not worth it: the whole value is cheaper
+        if (delta.size() >= size - size / 4)
+        {
+            delta.clear();
+            keyframe(value);
+            return false;
+        }
+    }
+
+    m_base = value;
+    m_stats.sentBytes += static_cast<quint64>(delta.size());
+    return true;
+}
+
+bool DeltaCodec::decode(const QByteArray &base, const QByteArray &data, int offset, QByteArray &result)
+{
+    if (data.size() < offset + HeaderSize)
+        return false;
+
+    quint32 totalSize;
+    quint16 blockSize;
+    memcpy(&totalSize, data.constData() + offset, sizeof(totalSize));
+    memcpy(&blockSize, data.constData() + offset + sizeof(totalSize), sizeof(blockSize));
+    if (!blockSize || totalSize != static_cast<quint32>(base.size()))
+        return false;
+
+    const int size = static_cast<int>(totalSize);
+    const int blocks = (size + blockSize - 1) / blockSize;
+    const int bitmapSize = (blocks + 7) / 8;
+    const unsigned char *bitmap = reinterpret_cast<const unsigned char*>(data.constData() + offset + HeaderSize);
+    int pos = offset + HeaderSize + bitmapSize;
+    if (pos > data.size())
+        return false;
+
+    result = base;
+    char *dst = result.data(); // detaches: the base stays intact
+    for (int i=0; i<blocks; i++)
+    {
+        if (!(bitmap[i / 8] & (1 << (i % 8))))
+            continue;
+
+        int at = i * blockSize;
+        int len = qMin(static_cast<int>(blockSize), size - at);
+        if (pos + len > data.size())
+            return false;
+        memcpy(dst + at, data.constData() + pos, static_cast<size_t>(len));
+        pos += len;
+    }
+    return true;
+}
@@ -0,0 +1,57 @@
+#ifndef DELTACODEC_H
+#define DELTACODEC_H
+
+#include <QByteArray>
+#include "xoCore_global.h"
+
+//! Block-level delta encoding of large values (Common and Image objects).
+//! A delta is [total size:4][block size:2][bitmap of changed blocks][changed blocks],
+//! it is applied to the previous value of the same size. Every KeyframeInterval-th value,
+//! any size change and any delta that doesn't pay off is sent as the whole value (keyframe),
+//! which also resynchronizes the receiver.
+class XOCORESHARED_EXPORT DeltaCodec
+{
+public:
+    static const int DefaultBlockSize = 256;
+    static const int KeyframeInterval = 50;
+    static const int HeaderSize = 6;
+
+    struct Stats
+    {
+        quint64 frames = 0;
+        quint64 keyframes = 0;
+        quint64 rawBytes = 0;  //!< size of the values
+        quint64 sentBytes = 0; //!< size of what was actually sent
+        double ratio() const { return sentBytes ? static_cast<double>(rawBytes) / sentBytes : 1.0; }
+        void add(int raw, int sent, bool keyframe)
+        {
+            frames++;
+            if (keyframe)
+                keyframes++;
+            rawBytes += static_cast<quint64>(raw);
+            sentBytes += static_cast<quint64>(sent);
+        }
+    };
+
+    explicit DeltaCodec(int blockSize = DefaultBlockSize);
+
+    //! returns false if the value must be sent as a keyframe, the delta is filled otherwise
+    bool encode(const QByteArray &value, QByteArray &delta);
+    //! force the next value to be a keyframe
+    void reset();
+
+    //! rebuild the value from the previous one and the delta starting at given offset
+    static bool decode(const QByteArray &base, const QByteArray &data, int offset, QByteArray &result);
+
+    const Stats &stats() const { return m_stats; }
+
+private:
+    int m_blockSize;
+    int m_sinceKeyframe = 0;
+    QByteArray m_base; //!< implicitly shared with the value last sent
+    Stats m_stats;
+
+    void keyframe(const QByteArray &value);
+};
+
+#endif // DELTACODEC_H
@@ -0,0 +1,29 @@
+#include "ImageFrame.h"
+
+ImageFrame::ImageFrame(const QByteArray &packetData, int offset) :
+    d(new Data)
+{
+    // a raw view into the packet would dangle in copies of the payload that outlive the frame
+    // (delta bases, queued packets), so a header is stripped with one copy when the frame is made
+    d->payload = offset > 0 ? packetData.mid(offset) : packetData;
+}
+
+const QByteArray &ImageFrame::payload() const
+{
+    static const QByteArray empty;
+    return d ? d->payload : empty;
+}
+
+const QImage &ImageFrame::image() const
+{
+    static const QImage empty;
+    return d ? d->image : empty;
+}
+
+void ImageFrame::setImage(const QImage &image) const
+{
+    if (!d)
+        return;
+    d->image = image;
+    d->decoded = true;
+}
@@ -0,0 +1,38 @@
+#ifndef IMAGEFRAME_H
+#define IMAGEFRAME_H
+
+#include <QImage>
+#include <QByteArray>
+#include <QSharedData>
+#include "xoCore_global.h"
+
+//! Immutable image as received from a module: the serialized payload (format header and pixels)
+//! shared by reference between the object, its linked subscribers and outgoing packets.
+//! The payload is an ordinary implicitly shared QByteArray, so copies of it stay valid on their own.
+//! The QImage is decoded once, on first use, and shared by every copy of the frame.
+class XOCORESHARED_EXPORT ImageFrame
+{
+public:
+    ImageFrame() {}
+    explicit ImageFrame(const QByteArray &packetData, int offset = 0);
+
+    bool isNull() const { return !d; }
+    const QByteArray &payload() const;
+
+    bool isDecoded() const { return d && d->decoded; }
+    const QImage &image() const;
+    //! remember the decoded image for all copies of the frame
+    void setImage(const QImage &image) const;
+
+private:
+    struct Data : public QSharedData
+    {
+        QByteArray payload;
+        QImage image;
+        bool decoded = false;
+    };
+
+    QExplicitlySharedDataPointer<Data> d;
+};
+
+#endif // IMAGEFRAME_H
@@ -0,0 +1,24 @@
+#include "InProcessTransport.h"
+
+bool InProcessTransport::isSupported(const QObject *endpoint)
+{
+    if (!endpoint)
+        return false;
+
+    const QMetaObject *mo = endpoint->metaObject();
+    return mo->indexOfSignal("newPacket(ONBPacket)") >= 0 &&
+           mo->indexOfSlot("receivePacket(ONBPacket)") >= 0 &&
+           mo->indexOfSlot("connectInProcess()") >= 0;
+}
+
+bool InProcessTransport::connect(QObject *endpoint, ModuleProxyONB *proxy)
+{
+    if (!proxy || !isSupported(endpoint))
+        return false;
+
+    // queued both ways: a packet is never handled inside the emit of the other side
+    QObject::connect(endpoint, SIGNAL(newPacket(ONBPacket)), proxy, SLOT(receivePacket(ONBPacket)), Qt::QueuedConnection);
+    QObject::connect(proxy, SIGNAL(newPacket(ONBPacket)), endpoint, SLOT(receivePacket(ONBPacket)), Qt::QueuedConnection);
+
+    return QMetaObject::invokeMethod(endpoint, "connectInProcess", Qt::QueuedConnection);
+}
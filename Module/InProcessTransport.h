@@ -0,0 +1,27 @@
+#ifndef INPROCESSTRANSPORT_H
+#define INPROCESSTRANSPORT_H
+
+#include <QObject>
+#include "ModuleProxyONB.h"
+#include "xoCore_global.h"
+
+//! Packet link between a plugin living in the core process and its ModuleProxyONB.
+//! Packets go as ONBPacket objects through queued connections: the data is shared,
+//! nothing is framed, sent through a socket or parsed again.
+//! The ONB endpoint of the plugin has to provide (module library side):
+//!   signal newPacket(ONBPacket)     - packet to the core
+//!   slot   receivePacket(ONBPacket) - packet from the core
+//!   slot   connectInProcess()       - start the session as if the socket was connected
+//! Plugins without them keep using tryConnect() and the loopback socket.
+class XOCORESHARED_EXPORT InProcessTransport
+{
+public:
+    static bool isSupported(const QObject *endpoint);
+    //! the proxy is announced by the endpoint as on a socket connection
+    static bool connect(QObject *endpoint, ModuleProxyONB *proxy);
+
+private:
+    InProcessTransport() = delete;
+};
+
+#endif // INPROCESSTRANSPORT_H
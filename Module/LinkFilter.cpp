@@ -0,0 +1,255 @@
+#include "LinkFilter.h"
+#include "ObjectProxy.h"
+
+#include <type_traits>
+
+static const char *reduceNames[] = {"mean", "min", "max", "last"};
+
+template <typename T>
+static double readAs(const ObjectProxy *object)
+{
+    return static_cast<double>(object->get<T>());
+}
+
+template <typename T>
+static T fromDouble(double value, std::true_type) { return static_cast<T>(qRound64(value)); }
+template <typename T>
+static T fromDouble(double value, std::false_type) { return static_cast<T>(value); }
+
+//! exactly one packet per reduced value: set() sends only if the value changed
+template <typename T>
+static void writeAs(ObjectProxy *object, double value)
+{
+    T v = fromDouble<T>(value, std::is_integral<T>());
+    if (object->get<T>() == v)
+        object->send();
+    else
+        object->set<T>(v);
+}
+
+static double readVariant(const ObjectProxy *object)
+{
+    return object->value().toDouble();
+}
+
+static void writeVariant(ObjectProxy *object, double value)
+{
+    QVariant current = object->value();
+    QVariant v(value);
+    v.convert(current.userType());
+    bool changed = current != v;
+    object->setValue(v);
+    if (!changed)
+        object->send();
+}
+
+QJsonObject LinkFilter::Settings::toJson() const
+{
+    QJsonObject json;
+    if (rate)
+        json["rate"] = true;
+    if (decimate > 1)
+        json["decimate"] = decimate;
+    if (windowMs > 0)
+    {
+        json["window"] = windowMs;
+        json["reduce"] = reduceNames[reduce];
+    }
+    if (deadband > 0)
+        json["deadband"] = deadband;
+    if (relativeDeadband > 0)
+        json["relativeDeadband"] = relativeDeadband;
+    if (refreshMs > 0)
+        json["refresh"] = refreshMs;
+    return json;
+}
+
+LinkFilter::Settings LinkFilter::Settings::fromJson(const QJsonObject &json)
+{
+    Settings settings;
+    settings.rate = json.value("rate").toBool();
+    settings.decimate = qMax(1, json.value("decimate").toInt(1));
+    settings.windowMs = qMax(0, json.value("window").toInt());
+    settings.deadband = qMax(0.0, json.value("deadband").toDouble());
+    settings.relativeDeadband = qMax(0.0, json.value("relativeDeadband").toDouble());
+    settings.refreshMs = qMax(0, json.value("refresh").toInt());
+
+    QString reduce = json.value("reduce").toString();
+    for (int i = Mean; i <= Last; i++)
+        if (reduce == reduceNames[i])
+            settings.reduce = static_cast<Reduce>(i);
+    return settings;
+}
+
+LinkFilter::LinkFilter(const Settings &settings, ObjectProxy *publisher, ObjectProxy *subscriber, QObject *parent) :
+    QObject(parent),
+    m_settings(settings),
+    m_publisher(publisher),
+    m_subscriber(subscriber),
+    m_read(accessFor(publisher).read),
+    m_write(accessFor(subscriber).write)
+{
+    m_clock.start();
+
+    if (m_settings.windowMs > 0)
+    {
+        m_windowTimer = new QTimer(this);
+        m_windowTimer->setInterval(m_settings.windowMs);
+        connect(m_windowTimer, &QTimer::timeout, this, &LinkFilter::flushWindow);
+        m_windowTimer->start();
+    }
+
+    if (m_settings.refreshMs > 0)
+    {
+        m_refreshTimer = new QTimer(this);
+        m_refreshTimer->setInterval(m_settings.refreshMs);
+        connect(m_refreshTimer, &QTimer::timeout, this, &LinkFilter::refresh);
+        m_refreshTimer->start();
+    }
+}
+
+bool LinkFilter::isNumeric(const ObjectProxy *object)
+{
+    switch (object->value().userType())
+    {
+        case QMetaType::Char: case QMetaType::SChar: case QMetaType::UChar:
+        case QMetaType::Short: case QMetaType::UShort:
+        case QMetaType::Int: case QMetaType::UInt:
+        case QMetaType::Long: case QMetaType::ULong:
+        case QMetaType::LongLong: case QMetaType::ULongLong:
+        case QMetaType::Float: case QMetaType::Double:
+            return true;
+        default:
+            return false;
+    }
+}
+
+template <typename T>
+bool LinkFilter::accessAs(const ObjectProxy *object, Access &access)
+{
+    if (!object->holds<T>())
+        return false;
+    access.read = readAs<T>;
+    access.write = writeAs<T>;
+    return true;
+}
+
+LinkFilter::Access LinkFilter::accessFor(const ObjectProxy *object)
+{
+    // the types ComponentProxyONB creates numeric objects with
+    Access access;
+    if (accessAs<double>(object, access) || accessAs<float>(object, access) ||
+        accessAs<int32_t>(object, access) || accessAs<uint32_t>(object, access) ||
+        accessAs<int64_t>(object, access) || accessAs<uint64_t>(object, access) ||
+        accessAs<int16_t>(object, access) || accessAs<uint16_t>(object, access) ||
+        accessAs<int8_t>(object, access) || accessAs<uint8_t>(object, access) ||
+        accessAs<char>(object, access))
+        return access;
+
+    access.read = readVariant;
+    access.write = writeVariant;
+    return access;
+}
+
+void LinkFilter::take()
+{
+    if (!m_publisher)
+        return;
+
+    m_stats.received++;
+    double value = m_read(m_publisher);
+
+    if (m_settings.rate)
+    {
+        qint64 now = m_clock.nsecsElapsed();
+        bool first = m_previousTime < 0;
+        double dt = (now - m_previousTime) * 1e-9;
+        double previous = m_previous;
+        m_previous = value;
+        m_previousTime = now;
+        if (first || dt <= 0)
+            return;
+        value = (value - previous) / dt;
+    }
+
+    if (++m_skipped < m_settings.decimate)
+        return;
+    m_skipped = 0;
+
+    if (m_windowTimer)
+        accumulate(value);
+    else
+        offer(value);
+}
+
+void LinkFilter::accumulate(double value)
+{
+    if (!m_count)
+    {
+        m_sum = 0;
+        m_min = m_max = value;
+    }
+    m_count++;
+    m_sum += value;
+    m_min = qMin(m_min, value);
+    m_max = qMax(m_max, value);
+    m_last = value;
+}
+
+void LinkFilter::flushWindow()
+{
+    // nothing arrived in the window: nothing to say
+    if (!m_count)
+        return;
+
+    double value = m_last;
+    switch (m_settings.reduce)
+    {
+        case Mean: value = m_sum / m_count; break;
+        case Min: value = m_min; break;
+        case Max: value = m_max; break;
+        case Last: break;
+    }
+    m_count = 0;
+    offer(value);
+}
+
+void LinkFilter::offer(double value)
+{
+    if (m_settings.hasDeadband() && m_hasForwarded)
+    {
+        double band = qMax(m_settings.deadband, m_settings.relativeDeadband * qAbs(m_forwarded));
+        if (qAbs(value - m_forwarded) <= band)
+        {
+            m_stats.suppressed++;
+            m_held = true;
+            m_latest = value;
+            return;
+        }
+    }
+    forward(value);
+}
+
+void LinkFilter::refresh()
+{
+    // the timer restarts on every forwarded value, so it only fires after a quiet interval
+    if (!m_hasForwarded)
+        return;
+
+    forward(m_held ? m_latest : m_forwarded);
+}
+
+void LinkFilter::forward(double value)
+{
+    if (!m_subscriber)
+        return;
+
+    m_stats.forwarded++;
+    m_hasForwarded = true;
+    m_forwarded = value;
+    m_held = false;
+    if (m_refreshTimer)
+        m_refreshTimer->start();
+
+    m_write(m_subscriber, value);
+}
@@ -0,0 +1,112 @@
+#ifndef LINKFILTER_H
+#define LINKFILTER_H
+
+#include <QTimer>
+#include <QObject>
+#include <QPointer>
+#include <QJsonObject>
+#include <QElapsedTimer>
+#include "xoCore_global.h"
+
+class ObjectProxy;
+
+//! Reduction of a numeric link computed in the core: only the reduced values are sent to
+//! the subscriber. Stages are applied in order, each one is off by default:
+//! rate of change (per second) -> decimation (every N-th sample) -> time window (mean/min/max/last)
+//! -> deadband. A value held back by the deadband is still sent once the refresh interval passes.
+class XOCORESHARED_EXPORT LinkFilter : public QObject
+{
+    Q_OBJECT
+public:
+    enum Reduce
+    {
+        Mean,
+        Min,
+        Max,
+        Last
+    };
+
+    //! persisted in the connection JSON as
+    //! "filter": {"rate", "decimate", "window", "reduce", "deadband", "relativeDeadband", "refresh"}
+    struct Settings
+    {
+        bool rate = false;
+        int decimate = 1;   //!< forward every N-th sample
+        int windowMs = 0;   //!< 0: no window, samples are forwarded as they come
+        Reduce reduce = Mean;
+        double deadband = 0;         //!< changes up to this are not forwarded
+        double relativeDeadband = 0; //!< the same as a fraction of the last forwarded value
+        int refreshMs = 0;           //!< forward the latest value at least this often, 0: never
+
+        bool hasDeadband() const { return deadband > 0 || relativeDeadband > 0; }
+        bool isEmpty() const { return !rate && decimate <= 1 && windowMs <= 0 && !hasDeadband() && refreshMs <= 0; }
+        QJsonObject toJson() const;
+        static Settings fromJson(const QJsonObject &json);
+    };
+
+    //! counted since the link was made
+    struct Stats
+    {
+        quint64 received = 0;
+        quint64 forwarded = 0;
+        quint64 suppressed = 0; //!< held back by the deadband
+    };
+
+    LinkFilter(const Settings &settings, ObjectProxy *publisher, ObjectProxy *subscriber, QObject *parent = nullptr);
+
+    //! values of other types are not reduced, their links stay plain
+    static bool isNumeric(const ObjectProxy *object);
+
+    const Settings &settings() const { return m_settings; }
+    const Stats &stats() const { return m_stats; }
+
+public slots:
+    //! a new value of the publisher
+    void take();
+
+private:
+    Settings m_settings;
+    QPointer<ObjectProxy> m_publisher;
+    QPointer<ObjectProxy> m_subscriber;
+    Stats m_stats;
+
+    //! typed access to the values, resolved once from the object types;
+    //! Variant objects holding numbers are read and written through QVariant
+    typedef double (*Reader)(const ObjectProxy *object);
+    typedef void (*Writer)(ObjectProxy *object, double value);
+    struct Access
+    {
+        Reader read;
+        Writer write;
+    };
+    Reader m_read;
+    Writer m_write;
+    template <typename T> static bool accessAs(const ObjectProxy *object, Access &access);
+    static Access accessFor(const ObjectProxy *object);
+
+    QElapsedTimer m_clock;
+    double m_previous = 0;    //!< for the rate
+    qint64 m_previousTime = -1;
+    int m_skipped = 0;        //!< for the decimation
+
+    QTimer *m_windowTimer = nullptr;
+    int m_count = 0;
+    double m_sum = 0;
+    double m_min = 0;
+    double m_max = 0;
+    double m_last = 0;
+
+    QTimer *m_refreshTimer = nullptr;
+    bool m_hasForwarded = false;
+    double m_forwarded = 0;    //!< the deadband is measured from it
+    bool m_held = false;
+    double m_latest = 0;       //!< the value held back, sent on refresh
+
+    void accumulate(double value);
+    void flushWindow();
+    void offer(double value);
+    void refresh();
+    void forward(double value);
+};
+
+#endif // LINKFILTER_H
@@ -1,4 +1,7 @@
 #include "ModuleProxyONB.h"
+#include "Tracer.h"
+
+#include <QMetaMethod>
 
 ModuleProxyONB::ModuleProxyONB(QString module_name, QObject *parent) :
     QObject(parent),
@@ -9,6 +12,22 @@ ModuleProxyONB::ModuleProxyONB(QString module_name, QObject *parent) :
     timer->start(200);
 }
 
+void ModuleProxyONB::setClassCache(const QString &directory, const QByteArray &buildHash)
+{
+    m_classCache.reset(new ClassCache(directory, buildHash));
+    for (ComponentProxyONB *c: m_classInfo)
+        c->setClassCache(m_classCache.data());
+    for (ComponentProxyONB *c: m_components)
+        c->setClassCache(m_classCache.data());
+}
+
+QImage ModuleProxyONB::icon()
+{
+    if (m_icon.isNull() && !m_iconData.isEmpty())
+        m_icon = QImage::fromData(m_iconData);
+    return m_icon;
+}
+
 ComponentProxyONB *ModuleProxyONB::component(unsigned short compID) const
 {
     return m_components.value(compID, nullptr);
@@ -93,6 +112,8 @@ void ModuleProxyONB::receiveData(const QByteArray &data)
 
 void ModuleProxyONB::receivePacket(const ONBPacket &packet)
 {
+    m_traffic.packetsReceived++;
+    m_traffic.bytesReceived += packet.data().size();
     parsePacket(packet);
     unsigned short compID = packet.header().componentID;
     if (packet.header().classInfo)
@@ -148,6 +169,8 @@ void ModuleProxyONB::assignComponentID(unsigned short compID)
         connect(c, SIGNAL(newData(ONBPacket)), SLOT(sendPacket(ONBPacket)));
         connect(c, SIGNAL(ready()), SLOT(componentReady()));
         connect(c, SIGNAL(infoChanged()), SLOT(componentInfoChanged()));
+        connect(c, SIGNAL(descriptionComplete()), SLOT(storeClassDescription()));
+        c->setClassCache(m_classCache.data());
         m_components[compID] = c;
         c->requestInfo();
         emit componentAdded(compID);
@@ -219,7 +242,15 @@ bool ModuleProxyONB::renameComponent(QString name, QString newName)
 
 void ModuleProxyONB::sendPacket(const ONBPacket &packet)
 {
+    m_traffic.packetsSent++;
+    m_traffic.bytesSent += packet.data().size();
     emit newPacket(packet);
+
+    // in-process modules take the packet itself, nothing to serialize for them
+    static const QMetaMethod dataSignal = QMetaMethod::fromSignal(&ModuleProxyONB::newDataToSend);
+    if (!isSignalConnected(dataSignal))
+        return;
+
     QByteArray ba;
     packet.writePacket(ba);
     newDataToSend(ba);
@@ -237,7 +268,10 @@ void ModuleProxyONB::parsePacket(const ONBPacket &packet)
     {
       case svcIcon:
         if (!compID)
+        {
             m_iconData = packet.data();
+            m_icon = QImage();
+        }
         break;
 
       case svcEcho:
@@ -280,76 +314,163 @@ void ModuleProxyONB::sendClassInfoPacket(const ONBPacket &packet)
 void ModuleProxyONB::parseClassInfo(const ONBPacket &packet)
 {
     const ONBHeader &header = packet.header();
-//    qDebug() << "class info" << header.componentID << header.objectID;
 
     if (!header.componentID)
     {
         // if module contains no classes => it's ready
         if (header.objectID == svcClass && m_classes.isEmpty())
+        {
+            m_ready = true;
             emit ready();
+        }
         return;
     }
 
-    int idx = header.componentID - 1;
-    if (idx == m_classes.size())
+    // classes are enumerated in any order, the index only identifies the class in class info packets
+    uint32_t cid = m_classByIndex.value(header.componentID, 0);
+    if (!m_classByIndex.contains(header.componentID))
     {
-        if (header.objectID == svcClass)
+        if (header.objectID != svcClass)
         {
-            uint32_t cid = *reinterpret_cast<const uint32_t*>(packet.data().data());
-            if (m_classes.contains(cid))
-                qDebug() << "CLASSES already contains this shit!!";
-            m_classes << cid;
-            ComponentProxyONB *c = new ComponentProxyONB(header.componentID, this);
-            connect(c, SIGNAL(newData(ONBPacket)), SLOT(sendClassInfoPacket(ONBPacket)));
-            if (m_classInfo.contains(cid))
-                qDebug() << "CLASSINFO already contains this shit!!";
-            m_classInfo[cid] = c;
-            // request class info
-            ONBHeader hdr;
-            hdr.objectID = svcRequestAllInfo;
-            hdr.componentID = c->id();
-            hdr.classInfo = 1;
-            hdr.svc = 1;
-            hdr.local = 1;
-            QByteArray data(reinterpret_cast<const char*>(&cid), 4);
-            sendPacket(ONBPacket(hdr, data));
+            qDebug() << "[ModuleProxyONB] unknown class info received";
+            return;
         }
-        else
+
+        cid = *reinterpret_cast<const uint32_t*>(packet.data().data());
+        if (m_classes.contains(cid))
+            qDebug() << "CLASSES already contains this shit!!";
+        m_classes << cid;
+        m_classByIndex[header.componentID] = cid;
+        m_ready = false;
+        ComponentProxyONB *c = new ComponentProxyONB(header.componentID, this);
+        connect(c, SIGNAL(newData(ONBPacket)), SLOT(sendClassInfoPacket(ONBPacket)));
+        connect(c, SIGNAL(descriptionComplete()), SLOT(storeClassDescription()));
+        c->setClassCache(m_classCache.data());
+        if (m_classInfo.contains(cid))
+            qDebug() << "CLASSINFO already contains this shit!!";
+        m_classInfo[cid] = c;
+
+        // the same build was described before: no need to ask
+        const ClassCache::Entry *entry = m_classCache ? m_classCache->find(cid) : nullptr;
+        if (entry && entry->fromClassInfo && c->replayDescription(entry->transcript, true))
         {
-            qDebug() << "[ModuleProxyONB] unknown class info received";
+            XO_TRACE_DEBUG(Module, "class from cache", m_name, cid);
+            m_classRequested << cid;
+            registerClassName(cid, c);
         }
-    }
-    else if (idx < m_classes.size())
-    {
-        uint32_t cid = m_classes[idx];
-        ComponentProxyONB *c = m_classInfo[cid];
-        c->receiveData(packet);
-        if (c->isReady())
+        else if (m_requireAllClasses)
         {
-            if (QString(c->m_className).isEmpty())
-                c->m_className = c->componentName();
-            m_classMap[c->m_className] = cid;
+            requestClass(cid);
+        }
+        else
+        {
+            // details are requested when the class is needed
+            c->requestName();
         }
     }
     else
     {
-        qDebug() << "[ModuleProxyONB] unknown class info received";
+        ComponentProxyONB *c = m_classInfo[cid];
+        c->receiveData(packet);
+        // the name comes after the class name, the latter may be empty
+        if (c->isReady() || (header.objectID == svcName && !m_classRequested.contains(cid)))
+            registerClassName(cid, c);
     }
 
-//    qDebug() << name();
+    checkClassesReady();
+}
 
-    bool readyFlag = true;
-    for (auto &clinfo: m_classInfo)
-    {
-//        qDebug() << "    " << clinfo->componentType() << clinfo->isReady();
+bool ModuleProxyONB::requestClass(uint32_t cid)
+{
+    ComponentProxyONB *c = m_classInfo.value(cid, nullptr);
+    if (!c)
+        return false;
+    if (m_classRequested.contains(cid))
+        return true;
 
-        if (!clinfo->isReady())
-            readyFlag = false;
-    }
-    if (readyFlag)
+    m_classRequested << cid;
+    m_ready = false;
+
+    ONBHeader hdr;
+    hdr.objectID = svcRequestAllInfo;
+    hdr.componentID = c->id();
+    hdr.classInfo = 1;
+    hdr.svc = 1;
+    hdr.local = 1;
+    QByteArray data(reinterpret_cast<const char*>(&cid), 4);
+    sendPacket(ONBPacket(hdr, data));
+    return true;
+}
+
+bool ModuleProxyONB::requestClass(QString className)
+{
+    m_requiredClassNames << className;
+    if (!m_classMap.contains(className))
+        return false; // requested as soon as the name is known
+    return requestClass(m_classMap[className]);
+}
+
+void ModuleProxyONB::requireAllClasses()
+{
+    m_requireAllClasses = true;
+    for (uint32_t cid: m_classes)
+        requestClass(cid);
+    checkClassesReady();
+}
+
+void ModuleProxyONB::checkClassesReady()
+{
+    if (m_ready || m_classes.isEmpty())
+        return;
+
+    for (uint32_t cid: m_classes)
     {
-        emit ready();
+        ComponentProxyONB *c = m_classInfo[cid];
+        if (!m_classNamed.contains(cid) || (m_classRequested.contains(cid) && !c->isReady()))
+            return;
     }
+
+    m_ready = true;
+    emit ready();
+}
+
+void ModuleProxyONB::registerClassName(uint32_t cid, ComponentProxyONB *c)
+{
+    if (QString(c->m_className).isEmpty())
+        c->m_className = c->componentName();
+
+    QString name = c->m_className;
+    for (const QString &oldName : m_classMap.keys(cid))
+        if (oldName != name)
+            m_classMap.remove(oldName);
+    m_classMap[name] = cid;
+    m_classNamed << cid;
+
+    if (m_requiredClassNames.contains(name))
+        requestClass(cid);
+}
+
+void ModuleProxyONB::storeClassDescription()
+{
+    ComponentProxyONB *comp = qobject_cast<ComponentProxyONB*>(sender());
+    if (!comp || !m_classCache || !m_classCache->isEnabled())
+        return;
+
+    // replayed descriptions have no transcript, they are in the cache already
+    if (comp->descriptionTranscript().isEmpty())
+        return;
+
+    bool fromClassInfo = m_classInfo.value(comp->classId(), nullptr) == comp;
+    const ClassCache::Entry *cached = m_classCache->find(comp->classId());
+    if (cached && cached->version == comp->version() && (cached->fromClassInfo || !fromClassInfo))
+        return;
+
+    ClassCache::Entry entry;
+    entry.version = comp->version();
+    entry.objectCount = static_cast<quint8>(comp->objectCount());
+    entry.fromClassInfo = fromClassInfo;
+    entry.transcript = comp->descriptionTranscript();
+    m_classCache->store(comp->classId(), entry);
 }
 
 void ModuleProxyONB::componentReady()
@@ -365,7 +486,10 @@ void ModuleProxyONB::componentReady()
         m_classMap[proto->componentType()] = cid;
         m_classInfo[cid] = proto;
         m_classInfo[cid]->m_isFactory = false;
-        emit ready();
+        m_classNamed << cid;
+        m_classRequested << cid;
+        m_ready = false;
+        checkClassesReady();
     }
 
     ComponentProxyONB *proto = m_classInfo[cid];
@@ -1,9 +1,12 @@
 #ifndef MODULEPROXYONB_H
 #define MODULEPROXYONB_H
 
+#include <QSet>
 #include <QObject>
 #include <QTimer>
+#include <QScopedPointer>
 #include "ModuleConfig.h"
+#include "ClassCache.h"
 #include "ComponentProxyONB.h"
 #include "xoCore_global.h"
 
@@ -14,6 +17,15 @@ class XOCORESHARED_EXPORT ModuleProxyONB : public QObject
 public:
     Q_PROPERTY(QString name READ name)
 
+    //! packets passed to and from the module, bytes are payload sizes for both transports
+    struct Traffic
+    {
+        quint64 packetsSent = 0;
+        quint64 packetsReceived = 0;
+        quint64 bytesSent = 0;
+        quint64 bytesReceived = 0;
+    };
+
 private:
     QMap<unsigned short, ComponentProxyONB*> m_components;
     QMap<QString, ComponentProxyONB*> m_componentMap;
@@ -22,6 +34,19 @@ private:
     QHash<uint32_t, ComponentProxyONB*> m_classInfo;
     QString m_name;
     QByteArray m_iconData;
+    QImage m_icon; //!< decoded on first use
+    QScopedPointer<ClassCache> m_classCache;
+
+    QHash<unsigned short, uint32_t> m_classByIndex; //!< class info index => classID
+    QSet<uint32_t> m_classNamed;
+    QSet<uint32_t> m_classRequested;                 //!< classes with full info requested
+    QSet<QString> m_requiredClassNames;
+    bool m_requireAllClasses = false;
+    bool m_ready = false;
+    Traffic m_traffic;
+
+    void registerClassName(uint32_t cid, ComponentProxyONB *c);
+    void checkClassesReady();
 
 private slots:
     void receivePacket(const ONBPacket &packet);
@@ -33,6 +58,7 @@ private slots:
 
     void componentReady();
     void componentInfoChanged();
+    void storeClassDescription();
 
 public:
     explicit ModuleProxyONB(QString module_name, QObject *parent = nullptr);
@@ -40,9 +66,19 @@ public:
     ComponentProxyONB *component(unsigned short compID) const;
     ComponentProxyONB *component(QString name) const;
 
+    //! class prototype; only the names are known until the class is requested with requestClass()
     ComponentProxyONB *classInfo(uint32_t cid) const;
     ComponentProxyONB *classInfo(QString name) const;
 
+    //! fetch full info of the class, the module is ready again when it is received
+    bool requestClass(uint32_t cid);
+    //! the name may be not enumerated yet, then the class is requested when it is
+    Q_INVOKABLE bool requestClass(QString className);
+    //! full info of every class is needed (e.g. to write module config)
+    void requireAllClasses();
+    //! all classes are named and every requested class is described
+    bool isReady() const {return m_ready;}
+
     const QList<uint32_t> &classes() const;
     Q_INVOKABLE QStringList classNames() const;
     Q_INVOKABLE QStringList componentNames() const;
@@ -51,8 +87,12 @@ public:
 
     QString name() const {return m_name;}
     QList<ModuleConfig*> getModuleConfig(QString in_my_name = "", bool inInstances = false);
-    QImage icon() {return QImage::fromData(m_iconData);}
+    QImage icon();
     const QByteArray &iconData() const {return m_iconData;}
+    const Traffic &traffic() const {return m_traffic;}
+
+    //! classes of the module are described from the cache in this directory while the build hash matches
+    void setClassCache(const QString &directory, const QByteArray &buildHash);
 
     void enumerateClasses();
     void enumerateComponents();
@@ -0,0 +1,15 @@
+#ifndef ONBEXTENSIONS_H
+#define ONBEXTENSIONS_H
+
+//! Service object IDs the core uses on top of ONB.
+//! They must match the module library; a peer that doesn't know one answers svcFail
+//! and the core falls back to the plain ONB exchange for that component.
+enum ONBExtensionSvc
+{
+    svcDeltaObject = 0xE0, //!< [oid][reserved][DeltaCodec delta]; [oid] alone probes (and acknowledges) delta support
+    svcObjectBatch = 0xE1, //!< ObjectBatch of object values, both directions
+    svcRequestBatch = 0xE2, //!< [oid]...: values requested in one svcObjectBatch reply, none = all volatile outputs
+    svcRequestDelta = 0xE3, //!< [oid][on]: the peer sends the output as svcDeltaObject (on = 1) or whole (on = 0)
+};
+
+#endif // ONBEXTENSIONS_H
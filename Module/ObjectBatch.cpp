@@ -0,0 +1,39 @@
+#include "ObjectBatch.h"
+
+bool ObjectBatch::append(unsigned char oid, const QByteArray &data)
+{
+    if (data.size() > MaxRecordSize)
+        return false;
+
+    int size = data.size();
+    m_data.append(static_cast<char>(oid));
+    m_data.append(static_cast<char>(size & 0xFF));
+    m_data.append(static_cast<char>(size >> 8));
+    m_data.append(data);
+    m_count++;
+    return true;
+}
+
+bool ObjectBatch::parse(const QByteArray &data, QVector<Record> &records)
+{
+    const unsigned char *ptr = reinterpret_cast<const unsigned char*>(data.constData());
+    int pos = 0;
+    while (pos < data.size())
+    {
+        if (pos + 3 > data.size())
+            return false;
+
+        Record record;
+        record.oid = ptr[pos];
+        int size = ptr[pos + 1] | (ptr[pos + 2] << 8);
+        pos += 3;
+
+        if (pos + size > data.size())
+            return false;
+
+        record.data = data.mid(pos, size);
+        records << record;
+        pos += size;
+    }
+    return true;
+}
@@ -0,0 +1,43 @@
+#ifndef OBJECTBATCH_H
+#define OBJECTBATCH_H
+
+#include <QByteArray>
+#include <QVector>
+#include "xoCore_global.h"
+
+//! Several ONB objects packed into one packet payload as a sequence of
+//! records [oid:1][size:2, little endian][data:size].
+//! Bulk requests use it so that a component with many objects costs one round-trip
+//! instead of one per object.
+class XOCORESHARED_EXPORT ObjectBatch
+{
+public:
+    struct Record
+    {
+        unsigned char oid;
+        QByteArray data;
+    };
+
+    //! flags sent with svcRequestObjInfo; peers that don't know them answer per object
+    enum DescribeFlags
+    {
+        DescribeWithMeta = 0x01
+    };
+
+    static const int MaxRecordSize = 0xFFFF;
+
+    //! returns false if the data doesn't fit into a record
+    bool append(unsigned char oid, const QByteArray &data);
+    bool isEmpty() const { return m_data.isEmpty(); }
+    int count() const { return m_count; }
+    const QByteArray &data() const { return m_data; }
+
+    //! returns false if the payload is damaged, records before the damage are still returned
+    static bool parse(const QByteArray &data, QVector<Record> &records);
+
+private:
+    QByteArray m_data;
+    int m_count = 0;
+};
+
+#endif // OBJECTBATCH_H
@@ -0,0 +1,123 @@
+#include "ObjectObserver.h"
+#include "ComponentProxyONB.h"
+
+ObjectObserver::ObjectObserver(int maxRate, QObject *parent) : QObject(parent),
+    m_maxRate(qMax(1, maxRate))
+{
+    m_timer.setSingleShot(true);
+    connect(&m_timer, &QTimer::timeout, this, &ObjectObserver::flush);
+}
+
+ObjectObserver::~ObjectObserver()
+{
+    unwatchAll();
+}
+
+void ObjectObserver::setMaxRate(int maxRate)
+{
+    m_maxRate = qMax(1, maxRate);
+}
+
+ObjectObserver::Key ObjectObserver::watch(ComponentProxyONB *component, unsigned char oid)
+{
+    Key k = key(component->id(), oid);
+    if (m_watched.contains(k))
+        return k;
+
+    m_watched << k;
+    m_components[component->id()] = component;
+    component->addObserver(oid, this);
+    return k;
+}
+
+bool ObjectObserver::watch(ComponentProxyONB *component, QString name, Key *key)
+{
+    ObjectProxy *obj = component->object(name);
+    if (!obj)
+        return false;
+
+    Key k = watch(component, static_cast<unsigned char>(obj->id));
+    if (key)
+        *key = k;
+    return true;
+}
+
+void ObjectObserver::unwatch(ComponentProxyONB *component, unsigned char oid)
+{
+    Key k = key(component->id(), oid);
+    if (!m_watched.remove(k))
+        return;
+
+    component->removeObserver(oid, this);
+    m_pendingSet.remove(k);
+    m_pending.removeOne(k);
+}
+
+void ObjectObserver::unwatchAll()
+{
+    for (Key k : m_watched)
+    {
+        ComponentProxyONB *component = m_components.value(componentId(k));
+        if (component)
+            component->removeObserver(objectId(k), this);
+    }
+    m_watched.clear();
+    m_components.clear();
+    m_pending.clear();
+    m_pendingSet.clear();
+    m_timer.stop();
+}
+
+ObjectProxy *ObjectObserver::object(Key key) const
+{
+    ComponentProxyONB *component = m_components.value(componentId(key));
+    if (!component)
+        return nullptr;
+    return const_cast<ObjectProxy*>(component->object(objectId(key)));
+}
+
+void ObjectObserver::notify(Key key)
+{
+    if (m_pendingSet.contains(key))
+        return;
+
+    m_pendingSet << key;
+    m_pending << key;
+
+    if (m_timer.isActive())
+        return;
+
+    // the first change after a quiet period goes out at once, the next ones wait for the tick
+    int interval = 1000 / m_maxRate;
+    qint64 elapsed = m_lastBatch.isValid() ? m_lastBatch.elapsed() : interval;
+    m_timer.start(static_cast<int>(qMax<qint64>(0, interval - elapsed)));
+}
+
+void ObjectObserver::componentDestroyed(ComponentProxyONB *component)
+{
+    unsigned short id = component->id();
+    m_components.remove(id);
+    for (auto it = m_watched.begin(); it != m_watched.end();)
+    {
+        if (componentId(*it) == id)
+        {
+            m_pendingSet.remove(*it);
+            m_pending.removeOne(*it);
+            it = m_watched.erase(it);
+        }
+        else
+            ++it;
+    }
+}
+
+void ObjectObserver::flush()
+{
+    if (m_pending.isEmpty())
+        return;
+
+    QVector<Key> keys;
+    keys.swap(m_pending);
+    m_pendingSet.clear();
+    m_lastBatch.start();
+    emit changed(keys);
+}
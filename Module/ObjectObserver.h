@@ -0,0 +1,64 @@
+#ifndef OBJECTOBSERVER_H
+#define OBJECTOBSERVER_H
+
+#include <QHash>
+#include <QSet>
+#include <QTimer>
+#include <QVector>
+#include <QObject>
+#include <QPointer>
+#include <QElapsedTimer>
+#include "xoCore_global.h"
+
+class ObjectProxy;
+class ComponentProxyONB;
+
+//! Change notifications for UI and plugins without per-packet signals.
+//! Objects are watched by integer key, changes are coalesced and delivered as one batch
+//! of keys at most maxRate times per second, however fast the objects change.
+class XOCORESHARED_EXPORT ObjectObserver : public QObject
+{
+    Q_OBJECT
+public:
+    typedef quint32 Key;
+
+    static Key key(unsigned short componentID, unsigned char oid) { return (static_cast<Key>(componentID) << 8) | oid; }
+    static unsigned short componentId(Key key) { return static_cast<unsigned short>(key >> 8); }
+    static unsigned char objectId(Key key) { return static_cast<unsigned char>(key & 0xFF); }
+
+    explicit ObjectObserver(int maxRate = 30, QObject *parent = nullptr);
+    ~ObjectObserver() override;
+
+    int maxRate() const { return m_maxRate; }
+    void setMaxRate(int maxRate);
+
+    Key watch(ComponentProxyONB *component, unsigned char oid);
+    //! returns false if the component has no such object
+    bool watch(ComponentProxyONB *component, QString name, Key *key = nullptr);
+    void unwatch(ComponentProxyONB *component, unsigned char oid);
+    void unwatchAll();
+
+    //! nullptr if the component is gone
+    ObjectProxy *object(Key key) const;
+
+signals:
+    //! keys changed since the previous batch, each key once
+    void changed(const QVector<quint32> &keys);
+
+private:
+    int m_maxRate;
+    QHash<unsigned short, QPointer<ComponentProxyONB>> m_components;
+    QSet<Key> m_watched;
+    QVector<Key> m_pending;
+    QSet<Key> m_pendingSet;
+    QTimer m_timer;
+    QElapsedTimer m_lastBatch;
+
+    friend class ComponentProxyONB;
+    //! called by the component for every change of a watched object
+    void notify(Key key);
+    void componentDestroyed(ComponentProxyONB *component);
+    void flush();
+};
+
+#endif // OBJECTOBSERVER_H
@@ -1,5 +1,7 @@
 #include "ObjectProxy.h"
 #include "ComponentProxyONB.h"
+#include "LinkFilter.h"
+#include "Tracer.h"
 
 ObjectProxy::ObjectProxy(ComponentProxyONB *component, const ObjectDescription &desc) :
     mComponent(component)
@@ -9,6 +11,7 @@ ObjectProxy::ObjectProxy(ComponentProxyONB *component, const ObjectDescription &
 
 ObjectProxy::~ObjectProxy()
 {
+    delete m_deltaEncoder;
 }
 
 bool ObjectProxy::isValid()
@@ -47,15 +50,22 @@ QJsonObject ObjectProxy::getDescriptionJSON() const
     return json;
 }
 
-bool ObjectProxy::link(ObjectProxy *publisher, ObjectProxy *subscriber)
+bool ObjectProxy::link(ObjectProxy *publisher, ObjectProxy *subscriber, LinkFilter *filter)
 {
     ObjectDescription &pubDesc = publisher->m_description;
     ObjectDescription &subDesc = subscriber->m_description;
 
-    qDebug() << "[ObjectProxy] LINK"
-             << publisher->name() << "(" << publisher->typeName() << "," << publisher->RMIP << "ms )"
-             << "->"
-             << subscriber->name() << "(" << subscriber->typeName() << "," << subscriber->RMIP << "ms )";
+    XO_TRACE_DEBUG(Link, "link", publisher->name() + " -> " + subscriber->name(), publisher->RMIP, subscriber->RMIP);
+
+    if (filter)
+    {
+        // the filter is deleted on unlink, which disconnects it
+        if (publisher->m_needTimestamp || !publisher->m_RMIP)
+            connect(publisher, &ObjectProxy::received, filter, &LinkFilter::take);
+        else
+            connect(publisher, &ObjectProxy::valueChanged, filter, &LinkFilter::take);
+        return true;
+    }
 
     if (/*(pubDesc.size || pubDesc.type == Common) &&*/
         (pubDesc.type == subDesc.type)
@@ -89,6 +99,42 @@ bool ObjectProxy::unlink(ObjectProxy *publisher, ObjectProxy *subscriber)
     return true;
 }
 
+const ObjectProxy *ObjectProxy::frameSource() const
+{
+    if (mLinkedPublisher && mLinkedPublisher->type() == type())
+        return mLinkedPublisher->frameSource();
+    return this;
+}
+
+void ObjectProxy::setFrame(const ImageFrame &frame)
+{
+    m_frame = frame;
+    m_frameDecoded = false;
+}
+
+QByteArray ObjectProxy::payload() const
+{
+    const ImageFrame &f = frame();
+    if (!f.isNull())
+        return f.payload();
+    return read();
+}
+
+bool ObjectProxy::setDeltaMode(bool enabled)
+{
+    if (enabled && type() != Common && type() != Image)
+        return false;
+
+    if (enabled && !m_deltaEncoder)
+        m_deltaEncoder = new DeltaCodec();
+    else if (!enabled && m_deltaEncoder)
+    {
+        delete m_deltaEncoder;
+        m_deltaEncoder = nullptr;
+    }
+    return true;
+}
+
 void ObjectProxy::request() const
 {
     mComponent->requestObject(m_description.id);
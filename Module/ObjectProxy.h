@@ -6,8 +6,12 @@
 #include <QVariant>
 #include <QObject>
 #include <QTimer>
+#include <QImage>
+#include "ImageFrame.h"
+#include "DeltaCodec.h"
 #include "xoCore_global.h"
 
+class LinkFilter;
 class ComponentProxyONB;
 
 class XOCORESHARED_EXPORT ObjectProxy : public QObject, virtual public ObjectBase
@@ -18,12 +22,41 @@ public:
     virtual ~ObjectProxy() override;
 
     bool isValid();
+    ComponentProxyONB *component() const { return mComponent; }
 
     QJsonObject getDescriptionJSON() const;
 
     virtual QVariant value() const = 0;
     virtual bool setValue(QVariant v) = 0;
 
+    //! view of the bytes of a QByteArray value or the pixels of a QImage value
+    struct RawSpan
+    {
+        const char *data = nullptr;
+        int size = 0;
+    };
+
+    //! typed access without QVariant: the type is checked once, then the value is read/written in place
+    template <typename T> bool holds() const { return valueTypeId() == qMetaTypeId<T>(); }
+    template <typename T> const T *ptr() const;
+    template <typename T> T get(const T &defaultValue = T()) const;
+    template <typename T> bool set(const T &value);
+    //! empty for fixed-size types
+    virtual RawSpan rawSpan() const { return RawSpan(); }
+
+    //! last received frame of an Image object, shared with linked subscribers (null for other types)
+    const ImageFrame &frame() const { return frameSource()->m_frame; }
+    //! serialized value to send: the received frame as is, or the value serialized
+    QByteArray payload() const;
+
+    //! send block-level changes instead of the whole value (Common and Image objects only)
+    bool setDeltaMode(bool enabled);
+    bool deltaMode() const { return m_deltaEncoder != nullptr; }
+    //! compression achieved so far, nullptr if delta mode is off
+    const DeltaCodec *deltaCodec() const { return m_deltaEncoder; }
+    //! compression of the values received since the publisher was asked for deltas, nullptr if it wasn't
+    const DeltaCodec::Stats *deltaReceived() const { return m_deltaRequested ? &m_deltaReceivedStats : nullptr; }
+
     QVariant min() const {return testExtFlag(MV_Min)? getMeta(MV_Min): QVariant();}
     QVariant max() const {return testExtFlag(MV_Max)? getMeta(MV_Max): QVariant();}
     QVariant def() const {return testExtFlag(MV_Def)? getMeta(MV_Def): QVariant();}
@@ -34,7 +67,8 @@ public:
     QString options() const {return m_options;}
     QStringList enumList() const { return m_enum; }
 
-    static bool link(ObjectProxy *publisher, ObjectProxy *subscriber);
+    //! with a filter the subscriber keeps its own value, the filter sets it and sends it
+    static bool link(ObjectProxy *publisher, ObjectProxy *subscriber, LinkFilter *filter = nullptr);
     static bool unlink(ObjectProxy *publisher, ObjectProxy *subscriber);
 
     void subscribe(int period_ms = -1);
@@ -50,24 +84,60 @@ signals:
 
 protected:
     ObjectProxy(ComponentProxyONB *component, const ObjectDescription &desc);
-    void receiveEvent() override {emit received();}
-    void changeEvent() override {emit valueChanged();}
+    void receiveEvent() override {if (!m_silent) emit received();}
+    void changeEvent() override {if (!m_silent) emit valueChanged();}
 
     virtual bool linkTo(const ObjectProxy *publisher) = 0;
     virtual void unlink() = 0;
 
     virtual QVariant getMeta(MetaValue) const {return QVariant();}
+    virtual int valueTypeId() const = 0;
+
+    ImageFrame m_frame;
+    mutable bool m_frameDecoded = false;
+    bool m_silent = false; //!< no signals while a frame is decoded into the value
+
+    //! take the frame as the new value without decoding it
+    void setFrame(const ImageFrame &frame);
+    //! the frame of the linked publisher when the value is shared with it
+    const ObjectProxy *frameSource() const;
 
 private:
     ComponentProxyONB *mComponent = nullptr;
     QTimer *mAutoRequestTimer = nullptr;
     ObjectProxy *mLinkedPublisher = nullptr;
+    DeltaCodec *m_deltaEncoder = nullptr;
+    bool m_deltaRequested = false; //!< the publisher was asked to send deltas (see ComponentProxyONB::requestDelta)
+    DeltaCodec::Stats m_deltaReceivedStats;
 
     QVariant toVariant(const QByteArray &ba) const;
 
     friend class ComponentProxyONB;
 };
 
+template <typename T>
+ObjectProxy::RawSpan rawSpanOf(const T &) { return ObjectProxy::RawSpan(); }
+
+inline ObjectProxy::RawSpan rawSpanOf(const QByteArray &value)
+{
+    ObjectProxy::RawSpan span;
+    span.data = value.constData();
+    span.size = value.size();
+    return span;
+}
+
+inline ObjectProxy::RawSpan rawSpanOf(const QImage &value)
+{
+    ObjectProxy::RawSpan span;
+    span.data = reinterpret_cast<const char*>(value.constBits());
+#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+    span.size = static_cast<int>(value.sizeInBytes());
+#else
+    span.size = value.byteCount();
+#endif
+    return span;
+}
+
 template <typename T>
 class ObjectProxyImpl : public ObjectProxy, public xoObjectBase<T>
 {
@@ -78,17 +148,24 @@ public:
 
     virtual QVariant value() const override
     {
+        decodeFrame();
         return *this->m_ptr; // this must be equal to the line below but it's simpler
 //        return QVariant::fromValue<T>(*this->m_ptr);
     }
     virtual bool setValue(QVariant v) override
     {
-        qDebug() << "ObjectProxyImpl set" << v;
-
         if (!v.canConvert(this->m_description.type))
             return false;
 
-        T newValue = v.value<T>();
+        return setTyped(v.value<T>());
+    }
+
+    const T *valuePtr() const { decodeFrame(); return this->m_ptr; }
+
+    bool setTyped(const T &newValue)
+    {
+        decodeFrame();
+        m_frame = ImageFrame();
         m_changed = (*this->m_ptr != newValue);
         *this->m_ptr = newValue;
 
@@ -98,6 +175,15 @@ public:
         return true;
     }
 
+    virtual RawSpan rawSpan() const override
+    {
+        decodeFrame();
+        return rawSpanOf(*this->m_ptr);
+    }
+
+    //! bring the value up to date with the received frame (only Image objects have frames)
+    void decodeFrame() const {}
+
     virtual QVariant getMeta(MetaValue meta) const
     {
         switch (meta)
@@ -111,6 +197,8 @@ public:
     }
 
 protected:
+    virtual int valueTypeId() const override { return qMetaTypeId<T>(); }
+
 #pragma warning (disable: 4250)
 //    using ObjectBase::readMeta;
 
@@ -133,4 +221,56 @@ protected:
     }
 };
 
+template <>
+inline void ObjectProxyImpl<QImage>::decodeFrame() const
+{
+    const ObjectProxy *source = frameSource();
+    if (source != this)
+    {
+        // the value is shared with the publisher, so is its frame
+        static_cast<const ObjectProxyImpl<QImage>*>(source)->decodeFrame();
+        return;
+    }
+
+    if (m_frame.isNull() || m_frameDecoded)
+        return;
+
+    auto self = const_cast<ObjectProxyImpl<QImage>*>(this);
+    if (m_frame.isDecoded())
+    {
+        *self->m_ptr = m_frame.image();
+    }
+    else
+    {
+        self->m_silent = true;
+        self->write(m_frame.payload());
+        self->m_silent = false;
+        m_frame.setImage(*this->m_ptr);
+    }
+    m_frameDecoded = true;
+}
+
+template <typename T>
+const T *ObjectProxy::ptr() const
+{
+    if (!holds<T>())
+        return nullptr;
+    return static_cast<const ObjectProxyImpl<T>*>(this)->valuePtr();
+}
+
+template <typename T>
+T ObjectProxy::get(const T &defaultValue) const
+{
+    const T *p = ptr<T>();
+    return p ? *p : defaultValue;
+}
+
+template <typename T>
+bool ObjectProxy::set(const T &value)
+{
+    if (!holds<T>())
+        return false;
+    return static_cast<ObjectProxyImpl<T>*>(this)->setTyped(value);
+}
+
 #endif // OBJECTPROXY_H
@@ -1,6 +1,8 @@
 #include <QDir>
 #include "ModuleList.h"
 #include "Core.h"
+#include "ConfigCatalog.h"
+#include "StartupProfiler.h"
 
 ModuleList *ModuleList::instance = nullptr;
 
@@ -29,13 +31,21 @@ ModuleList::~ModuleList()
 
 void ModuleList::init()
 {
+    ConfigCatalog::Instance()->build();
+
     QStringList moduleDirectoryPaths = getPathFiles(Core::FolderModules);
     for(const auto& moduleDirectoryPath : moduleDirectoryPaths)
+    {
+        XO_PROFILE_SCOPE("parse module config", moduleDirectoryPath);
         parse(moduleDirectoryPath, ModuleConfig::Type::MODULE);
+    }
 
     QStringList pluginsDirectoryPaths = getPathFiles(Core::FolderPlugins);
     for(const auto& pluginDirectoryPath : pluginsDirectoryPaths)
+    {
+        XO_PROFILE_SCOPE("parse plugin config", pluginDirectoryPath);
         parse(pluginDirectoryPath, ModuleConfig::Type::PLUGIN);
+    }
 }
 
 QStringList ModuleList::getPathFiles(QString in_path)
@@ -139,12 +149,13 @@ void ModuleList::refreshConfigList()
     {
         for(auto& module : hub->getModules())
         {
-            QString moduleName = module->name();
-            for (QString componentName : module->classNames())
+            // one call describes every class of the module
+            for (auto pConfig : module->getModuleConfig(module->name()))
             {
-                QList<ModuleConfig*> list = module->getModuleConfig(moduleName);
-                for (auto pConfig : list)
-                    configs[pConfig->name] = pConfig;
+                ModuleConfig *previous = configs.value(pConfig->name);
+                if (previous != pConfig)
+                    delete previous;
+                configs[pConfig->name] = pConfig;
             }
         }
     }
@@ -154,18 +165,15 @@ void ModuleList::parse(QString moduleDirectoryPath, ModuleConfig::Type type)
 {
     QString moduleName = QDir(moduleDirectoryPath).dirName();
 
-    QString moduleConfigPath = Core::FolderConfigs + moduleName + "/";
-    for(auto entry : QDir(moduleConfigPath).entryList(QDir::Files))
+    QJsonObject moduleConfigs = ConfigCatalog::Instance()->moduleConfigs(moduleName);
+    for(auto it = moduleConfigs.constBegin(); it != moduleConfigs.constEnd(); ++it)
     {
-        QFile file(moduleConfigPath + entry);
-        if(!file.open(QIODevice::ReadOnly)) continue;
-
         auto config = new ModuleConfig();
         config->type = type;
-        configs[QFileInfo(entry).baseName()] = config;
+        delete configs.value(it.key());
+        configs[it.key()] = config;
 
-        QJsonDocument document = QJsonDocument::fromJson(file.readAll());
-        parseJSON(document.object(), config);
+        parseJSON(it.value().toObject(), config);
     }
 };
 
@@ -0,0 +1,179 @@
+#include "ModuleMonitor.h"
+
+#include <QFile>
+
+#include "Hub.h"
+
+#ifdef Q_OS_LINUX
+#include <unistd.h>
+#endif
+
+ModuleMonitor::ModuleMonitor(Hub *hub, QObject *parent) : QObject(parent),
+    m_hub(hub)
+{
+    m_timer = new QTimer(this);
+    m_timer->setInterval(DefaultIntervalMs);
+    connect(m_timer, &QTimer::timeout, this, &ModuleMonitor::sampleAll);
+    m_timer->start();
+}
+
+void ModuleMonitor::watch(const QString &moduleName, qint64 pid)
+{
+    m_pids[moduleName] = pid;
+}
+
+void ModuleMonitor::unwatch(const QString &moduleName)
+{
+    m_pids.remove(moduleName);
+    m_samples[moduleName].pid = 0;
+}
+
+void ModuleMonitor::sampleAll()
+{
+    double dt = m_clock.isValid() ? m_clock.restart() * 0.001 : 0;
+    if (!m_clock.isValid())
+        m_clock.start();
+
+    auto rate = [dt](quint64 current, quint64 previous) { return dt > 0 && current >= previous ? (current - previous) / dt : 0.0; };
+
+#ifdef Q_OS_LINUX
+    static const double ticksPerSecond = static_cast<double>(sysconf(_SC_CLK_TCK));
+#endif
+
+    for (ModuleProxyONB *module : m_hub->getModules())
+    {
+        bool known = m_samples.contains(module->name());
+        Sample &sample = m_samples[module->name()];
+        const ModuleProxyONB::Traffic &traffic = module->traffic();
+        if (!known)
+        {
+            sample.bytesSent = traffic.bytesSent;
+            sample.bytesReceived = traffic.bytesReceived;
+        }
+        sample.txRate = rate(traffic.bytesSent, sample.bytesSent);
+        sample.rxRate = rate(traffic.bytesReceived, sample.bytesReceived);
+        sample.bytesSent = traffic.bytesSent;
+        sample.bytesReceived = traffic.bytesReceived;
+    }
+
+    for (auto it = m_pids.constBegin(); it != m_pids.constEnd(); ++it)
+    {
+        Sample &sample = m_samples[it.key()];
+        quint64 cpuTicks = 0, voluntary = 0, involuntary = 0, readBytes = 0, writeBytes = 0;
+        bool first = sample.pid != it.value();
+        if (first)
+        {
+            sample.cpuPercent = sample.voluntarySwitchRate = sample.involuntarySwitchRate = 0;
+            sample.readRate = sample.writeRate = 0;
+        }
+        sample.pid = it.value();
+        if (!readProc(sample.pid, sample, cpuTicks, voluntary, involuntary, readBytes, writeBytes))
+            continue;
+
+        if (!first)
+        {
+#ifdef Q_OS_LINUX
+            sample.cpuPercent = rate(cpuTicks, sample.cpuTicks) / ticksPerSecond * 100.0;
+#endif
+            sample.voluntarySwitchRate = rate(voluntary, sample.voluntarySwitches);
+            sample.involuntarySwitchRate = rate(involuntary, sample.involuntarySwitches);
+            sample.readRate = rate(readBytes, sample.readBytes);
+            sample.writeRate = rate(writeBytes, sample.writeBytes);
+        }
+        sample.cpuTicks = cpuTicks;
+        sample.voluntarySwitches = voluntary;
+        sample.involuntarySwitches = involuntary;
+        sample.readBytes = readBytes;
+        sample.writeBytes = writeBytes;
+    }
+
+    emit sampled();
+}
+
+bool ModuleMonitor::readProc(qint64 pid, Sample &sample, quint64 &cpuTicks, quint64 &voluntary,
+                             quint64 &involuntary, quint64 &readBytes, quint64 &writeBytes)
+{
+#ifdef Q_OS_LINUX
+    QString dir = QString("/proc/%1/").arg(pid);
+
+    QFile stat(dir + "stat");
+    if (!stat.open(QIODevice::ReadOnly))
+        return false;
+
+    // the command may contain spaces and parentheses, fields are counted after the last ')'
+    QByteArray line = stat.readAll();
+    QList<QByteArray> fields = line.mid(line.lastIndexOf(')') + 2).split(' ');
+    if (fields.size() < 22)
+        return false;
+    cpuTicks = fields[11].toULongLong() + fields[12].toULongLong(); // utime + stime
+    sample.threads = fields[17].toInt();
+
+    QFile status(dir + "status");
+    if (status.open(QIODevice::ReadOnly))
+    {
+        while (!status.atEnd())
+        {
+            QByteArray row = status.readLine().simplified();
+            int colon = row.indexOf(':');
+            QByteArray key = row.left(colon);
+            QByteArray value = row.mid(colon + 2).split(' ').value(0);
+            if (key == "VmRSS")
+                sample.rssBytes = value.toLongLong() * 1024;
+            else if (key == "voluntary_ctxt_switches")
+                voluntary = value.toULongLong();
+            else if (key == "nonvoluntary_ctxt_switches")
+                involuntary = value.toULongLong();
+        }
+    }
+
+    // not readable without ptrace access, rates stay 0 then
+    QFile io(dir + "io");
+    if (io.open(QIODevice::ReadOnly))
+    {
+        while (!io.atEnd())
+        {
+            QByteArray row = io.readLine().simplified();
+            if (row.startsWith("read_bytes:"))
+                readBytes = row.mid(11).trimmed().toULongLong();
+            else if (row.startsWith("write_bytes:"))
+                writeBytes = row.mid(12).trimmed().toULongLong();
+        }
+    }
+    return true;
+#else
+    Q_UNUSED(pid) Q_UNUSED(sample) Q_UNUSED(cpuTicks) Q_UNUSED(voluntary)
+    Q_UNUSED(involuntary) Q_UNUSED(readBytes) Q_UNUSED(writeBytes)
+    return false;
+#endif
+}
+
+QJsonObject ModuleMonitor::stats() const
+{
+    QJsonObject result;
+    for (ModuleProxyONB *module : m_hub->getModules())
+    {
+        Sample sample = m_samples.value(module->name());
+        const ModuleProxyONB::Traffic &traffic = module->traffic();
+
+        QJsonObject json;
+        if (sample.pid)
+        {
+            json["pid"] = static_cast<double>(sample.pid);
+            json["cpuPercent"] = sample.cpuPercent;
+            json["rssBytes"] = static_cast<double>(sample.rssBytes);
+            json["threads"] = sample.threads;
+            json["voluntarySwitchesPerSec"] = sample.voluntarySwitchRate;
+            json["involuntarySwitchesPerSec"] = sample.involuntarySwitchRate;
+            json["readBytesPerSec"] = sample.readRate;
+            json["writeBytesPerSec"] = sample.writeRate;
+        }
+        json["packetsSent"] = static_cast<double>(traffic.packetsSent);
+        json["packetsReceived"] = static_cast<double>(traffic.packetsReceived);
+        json["bytesSent"] = static_cast<double>(traffic.bytesSent);
+        json["bytesReceived"] = static_cast<double>(traffic.bytesReceived);
+        json["txBytesPerSec"] = sample.txRate;
+        json["rxBytesPerSec"] = sample.rxRate;
+        result[module->name()] = json;
+    }
+    return result;
+}
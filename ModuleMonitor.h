@@ -0,0 +1,74 @@
+#ifndef MODULEMONITOR_H
+#define MODULEMONITOR_H
+
+#include <QHash>
+#include <QTimer>
+#include <QObject>
+#include <QJsonObject>
+#include <QElapsedTimer>
+#include "xoCore_global.h"
+
+class Hub;
+
+//! Resource usage of module processes sampled from /proc (Linux only), joined with the
+//! traffic counters of the module proxies. Modules living in the core process (plugins)
+//! have traffic only.
+class XOCORESHARED_EXPORT ModuleMonitor : public QObject
+{
+    Q_OBJECT
+public:
+    static const int DefaultIntervalMs = 2000;
+
+    struct Sample
+    {
+        qint64 pid = 0;
+        double cpuPercent = 0;          //!< of one CPU
+        qint64 rssBytes = 0;
+        int threads = 0;
+        double voluntarySwitchRate = 0; //!< per second
+        double involuntarySwitchRate = 0;
+        double readRate = 0;            //!< bytes per second, storage I/O
+        double writeRate = 0;
+        double txRate = 0;              //!< bytes per second, ONB payload
+        double rxRate = 0;
+
+        // raw counters of the previous sample, rates are their deltas
+        quint64 cpuTicks = 0;
+        quint64 voluntarySwitches = 0;
+        quint64 involuntarySwitches = 0;
+        quint64 readBytes = 0;
+        quint64 writeBytes = 0;
+        quint64 bytesSent = 0;
+        quint64 bytesReceived = 0;
+    };
+
+    explicit ModuleMonitor(Hub *hub, QObject *parent = nullptr);
+
+    void setInterval(int ms) { m_timer->setInterval(ms); }
+    int interval() const { return m_timer->interval(); }
+
+    void watch(const QString &moduleName, qint64 pid);
+    void unwatch(const QString &moduleName);
+
+    Sample sample(const QString &moduleName) const { return m_samples.value(moduleName); }
+    //! per module: pid, cpuPercent, rssBytes, threads, switch, I/O and traffic rates, traffic totals
+    Q_INVOKABLE QJsonObject stats() const;
+
+signals:
+    void sampled();
+
+private slots:
+    void sampleAll();
+
+private:
+    Hub *m_hub;
+    QTimer *m_timer;
+    QElapsedTimer m_clock;
+    QHash<QString, qint64> m_pids;
+    QHash<QString, Sample> m_samples;
+
+    static bool readProc(qint64 pid, Sample &sample, quint64 &cpuTicks, quint64 &voluntary,
+                         quint64 &involuntary, quint64 &readBytes, quint64 &writeBytes);
+};
+
+#endif // MODULEMONITOR_H
@@ -0,0 +1,177 @@
+#include "ModuleProcess.h"
+
+#include <QDir>
+#include <QFile>
+
+#include "Tracer.h"
+
+#ifdef Q_OS_LINUX
+#include <sched.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#endif
+
+const QString ModuleProcess::CgroupRoot = "/sys/fs/cgroup/xorde";
+
+bool ModuleLaunchOptions::isEmpty() const
+{
+    return cpus.isEmpty() && !nice && !fifoPriority && !memoryLimit && !cpuLimitPercent;
+}
+
+ModuleLaunchOptions ModuleLaunchOptions::parse(const QStringList &tokens)
+{
+    ModuleLaunchOptions options;
+    for (const QString &token : tokens)
+    {
+        QString key = token.section('=', 0, 0);
+        QString value = token.section('=', 1);
+
+        if (key == "cpus")
+        {
+            for (const QString &cpu : value.split(','))
+                if (!cpu.isEmpty())
+                    options.cpus << cpu.toInt();
+        }
+        else if (key == "nice")
+        {
+            options.nice = qBound(-20, value.toInt(), 19);
+        }
+        else if (key == "fifo")
+        {
+            options.fifoPriority = qBound(0, value.toInt(), 99);
+        }
+        else if (key == "memory")
+        {
+            qint64 scale = 1;
+            if (value.endsWith('K', Qt::CaseInsensitive)) scale = 1LL << 10;
+            else if (value.endsWith('M', Qt::CaseInsensitive)) scale = 1LL << 20;
+            else if (value.endsWith('G', Qt::CaseInsensitive)) scale = 1LL << 30;
+            if (scale > 1)
+                value.chop(1);
+            options.memoryLimit = value.toLongLong() * scale;
+        }
+        else if (key == "cpu")
+        {
+            if (value.endsWith('%'))
+                value.chop(1);
+            options.cpuLimitPercent = qMax(0, value.toInt());
+        }
+    }
+    return options;
+}
+
+QStringList ModuleLaunchOptions::toTokens() const
+{
+    QStringList tokens;
+    if (!cpus.isEmpty())
+    {
+        QStringList list;
+        for (int cpu : cpus)
+            list << QString::number(cpu);
+        tokens << "cpus=" + list.join(',');
+    }
+    if (nice)
+        tokens << QString("nice=%1").arg(nice);
+    if (fifoPriority)
+        tokens << QString("fifo=%1").arg(fifoPriority);
+    if (memoryLimit)
+        tokens << QString("memory=%1").arg(memoryLimit);
+    if (cpuLimitPercent)
+        tokens << QString("cpu=%1%").arg(cpuLimitPercent);
+    return tokens;
+}
+
+ModuleProcess::ModuleProcess(const QString &moduleName, const ModuleLaunchOptions &options, QObject *parent) :
+    QProcess(parent),
+    m_moduleName(moduleName),
+    m_options(options)
+{
+#ifdef Q_OS_LINUX
+    if ((m_options.memoryLimit || m_options.cpuLimitPercent) && !prepareCgroup())
+        XO_TRACE_WARNING(Loader, "cgroup limits are not applied", moduleName);
+
+    if (m_options.fifoPriority)
+        connect(this, &QProcess::started, this, &ModuleProcess::checkScheduling);
+#else
+    if (!m_options.isEmpty())
+        XO_TRACE_WARNING(Loader, "launch options are supported on Linux only", moduleName);
+#endif
+}
+
+bool ModuleProcess::prepareCgroup()
+{
+    if (!QFile::exists("/sys/fs/cgroup/cgroup.controllers"))
+        return false;
+
+    QString group = CgroupRoot + "/" + m_moduleName;
+    if (!QDir().mkpath(group))
+        return false;
+
+    auto writeFile = [](const QString &path, const QByteArray &data)
+    {
+        QFile file(path);
+        return file.open(QIODevice::WriteOnly) && file.write(data) == data.size();
+    };
+
+    // controllers have to be enabled for the groups of the modules
+    writeFile(CgroupRoot + "/cgroup.subtree_control", "+memory +cpu");
+
+    if (m_options.memoryLimit && !writeFile(group + "/memory.max", QByteArray::number(m_options.memoryLimit)))
+        return false;
+
+    static const int CpuPeriodUs = 100000;
+    if (m_options.cpuLimitPercent &&
+        !writeFile(group + "/cpu.max", QByteArray::number(CpuPeriodUs / 100 * m_options.cpuLimitPercent) + " " + QByteArray::number(CpuPeriodUs)))
+        return false;
+
+    m_cgroupProcs = QFile::encodeName(group + "/cgroup.procs");
+    return true;
+}
+
+void ModuleProcess::setupChildProcess()
+{
+#ifdef Q_OS_LINUX
+    // runs in the forked child: system calls only, nothing is allocated
+    if (!m_cgroupProcs.isEmpty())
+    {
+        int fd = ::open(m_cgroupProcs.constData(), O_WRONLY);
+        if (fd >= 0)
+        {
+            // "0" moves the writing process
+            ssize_t written = ::write(fd, "0", 1);
+            Q_UNUSED(written)
+            ::close(fd);
+        }
+    }
+
+    if (!m_options.cpus.isEmpty())
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu : m_options.cpus)
+            if (cpu >= 0 && cpu < CPU_SETSIZE)
+                CPU_SET(cpu, &set);
+        sched_setaffinity(0, sizeof(set), &set);
+    }
+
+    if (m_options.nice)
+        setpriority(PRIO_PROCESS, 0, m_options.nice);
+
+    if (m_options.fifoPriority)
+    {
+        sched_param param;
+        param.sched_priority = m_options.fifoPriority;
+        sched_setscheduler(0, SCHED_FIFO, &param);
+    }
+#endif
+}
+
+void ModuleProcess::checkScheduling()
+{
+#ifdef Q_OS_LINUX
+    // the child can't report it, SCHED_FIFO needs CAP_SYS_NICE or an rtprio limit
+    if (sched_getscheduler(static_cast<pid_t>(processId())) != SCHED_FIFO)
+        XO_TRACE_WARNING(Loader, "SCHED_FIFO is not applied", m_moduleName, m_options.fifoPriority);
+#endif
+}
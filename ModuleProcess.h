@@ -0,0 +1,50 @@
+#ifndef MODULEPROCESS_H
+#define MODULEPROCESS_H
+
+#include <QProcess>
+#include <QStringList>
+#include "xoCore_global.h"
+
+//! Scheduling and resource options of a module process, given after the start type
+//! in the ModuleStartOptions file: "<module> <1|0> cpus=2,3 nice=-5 fifo=50 memory=512M cpu=150%".
+struct XOCORESHARED_EXPORT ModuleLaunchOptions
+{
+    QList<int> cpus;         //!< CPU affinity, empty = any
+    int nice = 0;
+    int fifoPriority = 0;    //!< SCHED_FIFO priority 1..99, 0 = default scheduling
+    qint64 memoryLimit = 0;  //!< bytes, cgroup v2 memory.max
+    int cpuLimitPercent = 0; //!< of one CPU, cgroup v2 cpu.max
+
+    bool isEmpty() const;
+    //! unknown tokens are ignored
+    static ModuleLaunchOptions parse(const QStringList &tokens);
+    QStringList toTokens() const;
+};
+
+//! Module process started with its launch options applied.
+//! Affinity and scheduling are set in the child before the module is executed, so the module
+//! never runs with the defaults. Limits are applied through a cgroup v2 group per module
+//! under CgroupRoot when cgroups are available and writable; otherwise they are skipped.
+//! Only Linux is supported, the options are ignored elsewhere.
+class XOCORESHARED_EXPORT ModuleProcess : public QProcess
+{
+    Q_OBJECT
+public:
+    static const QString CgroupRoot;
+
+    ModuleProcess(const QString &moduleName, const ModuleLaunchOptions &options, QObject *parent = nullptr);
+
+protected:
+    void setupChildProcess() override;
+
+private:
+    QString m_moduleName;
+    ModuleLaunchOptions m_options;
+    QByteArray m_cgroupProcs; //!< cgroup.procs of the module's group, empty if there are no limits
+
+    //! create the group and write its limits, false if cgroups can't be used
+    bool prepareCgroup();
+    void checkScheduling();
+};
+
+#endif // MODULEPROCESS_H
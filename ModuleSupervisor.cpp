@@ -0,0 +1,131 @@
+#include "ModuleSupervisor.h"
+
+#include <QDateTime>
+
+#include "Tracer.h"
+
+ModuleSupervisor::ModuleSupervisor(QObject *parent) : QObject(parent)
+{
+
+}
+
+void ModuleSupervisor::started(const QString &moduleName)
+{
+    Record &record = m_records[moduleName];
+    record.running = true;
+    record.uptime.start();
+}
+
+void ModuleSupervisor::exited(const QString &moduleName)
+{
+    Record &record = m_records[moduleName];
+    qint64 uptime = record.running ? record.uptime.elapsed() : 0;
+    record.running = false;
+
+    if (record.suspended || (record.timer && record.timer->isActive()))
+        return;
+
+    // a module that ran long enough is not crash-looping
+    if (uptime >= StableUptimeMs)
+        record.backoffMs = InitialBackoffMs;
+
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    while (!record.recentRestarts.isEmpty() && now - record.recentRestarts.first() > BudgetWindowMs)
+        record.recentRestarts.removeFirst();
+
+    if (record.recentRestarts.size() >= RestartBudget)
+    {
+        record.suspended = true;
+        XO_TRACE_ERROR(Loader, "module keeps crashing, restarts suspended", moduleName, record.restarts);
+        return;
+    }
+
+    if (!record.timer)
+    {
+        record.timer = new QTimer(this);
+        record.timer->setSingleShot(true);
+        connect(record.timer, &QTimer::timeout, this, [=]() { emit restartDue(moduleName); });
+    }
+
+    XO_TRACE_WARNING(Loader, "module exited, restart scheduled", moduleName, record.backoffMs);
+    record.recentRestarts << now;
+    record.restarts++;
+    record.timer->start(record.backoffMs);
+    record.backoffMs = qMin(record.backoffMs * 2, static_cast<int>(MaxBackoffMs));
+}
+
+void ModuleSupervisor::cancel(const QString &moduleName)
+{
+    auto it = m_records.find(moduleName);
+    if (it == m_records.end())
+        return;
+
+    it->running = false;
+    if (it->timer)
+        it->timer->stop();
+}
+
+void ModuleSupervisor::resume(const QString &moduleName)
+{
+    auto it = m_records.find(moduleName);
+    if (it == m_records.end())
+        return;
+
+    if (it->timer)
+        it->timer->stop();
+    it->suspended = false;
+    it->backoffMs = InitialBackoffMs;
+    it->recentRestarts.clear();
+}
+
+bool ModuleSupervisor::isHeldBack(const QString &moduleName) const
+{
+    auto it = m_records.constFind(moduleName);
+    if (it == m_records.constEnd())
+        return false;
+    return it->suspended || (it->timer && it->timer->isActive());
+}
+
+bool ModuleSupervisor::isSuspended(const QString &moduleName) const
+{
+    return m_records.value(moduleName).suspended;
+}
+
+int ModuleSupervisor::restartCount(const QString &moduleName) const
+{
+    return m_records.value(moduleName).restarts;
+}
+
+qint64 ModuleSupervisor::uptime(const QString &moduleName) const
+{
+    auto it = m_records.constFind(moduleName);
+    if (it == m_records.constEnd() || !it->running)
+        return 0;
+    return it->uptime.elapsed();
+}
+
+QJsonObject ModuleSupervisor::stats() const
+{
+    QJsonObject result;
+    for (auto it = m_records.constBegin(); it != m_records.constEnd(); ++it)
+    {
+        QJsonObject module;
+        module["restarts"] = it->restarts;
+        module["uptimeMs"] = static_cast<double>(it->running ? it->uptime.elapsed() : 0);
+        module["backoffMs"] = it->backoffMs;
+        module["pending"] = it->timer && it->timer->isActive();
+        module["suspended"] = it->suspended;
+        result[it.key()] = module;
+    }
+    return result;
+}
+
+void ModuleSupervisor::stop(QProcess *process)
+{
+    if (process->state() == QProcess::NotRunning)
+        return;
+
+    process->terminate();
+    // the timer dies with the process if it finishes in time
+    QTimer::singleShot(TerminateTimeoutMs, process, [=]() { process->kill(); });
+}
@@ -0,0 +1,70 @@
+#ifndef MODULESUPERVISOR_H
+#define MODULESUPERVISOR_H
+
+#include <QHash>
+#include <QTimer>
+#include <QObject>
+#include <QProcess>
+#include <QJsonObject>
+#include <QElapsedTimer>
+#include "xoCore_global.h"
+
+//! Restart policy of module processes.
+//! A module that exits unexpectedly is restarted after a delay that doubles with every
+//! crash and goes back to the initial one once the module has run for StableUptimeMs.
+//! A module restarted RestartBudget times within BudgetWindowMs is suspended until
+//! it is started explicitly again.
+class XOCORESHARED_EXPORT ModuleSupervisor : public QObject
+{
+    Q_OBJECT
+public:
+    static const int InitialBackoffMs = 500;
+    static const int MaxBackoffMs = 60000;
+    static const int StableUptimeMs = 30000;
+    static const int RestartBudget = 5;
+    static const int BudgetWindowMs = 300000;
+    static const int TerminateTimeoutMs = 3000;
+
+    explicit ModuleSupervisor(QObject *parent = nullptr);
+
+    //! process of the module is up
+    void started(const QString &moduleName);
+    //! process exited unexpectedly and the module is still needed: restartDue() follows later
+    void exited(const QString &moduleName);
+    //! drop a pending restart, e.g. when the module is killed on purpose
+    void cancel(const QString &moduleName);
+    //! forget the crash history, the next start is explicit
+    void resume(const QString &moduleName);
+
+    //! restart pending or restart budget exhausted: the module must not be started now
+    bool isHeldBack(const QString &moduleName) const;
+    bool isSuspended(const QString &moduleName) const;
+    int restartCount(const QString &moduleName) const;
+    //! 0 if the module is not running
+    qint64 uptime(const QString &moduleName) const;
+
+    //! per module: restarts, uptimeMs, backoffMs, pending, suspended
+    Q_INVOKABLE QJsonObject stats() const;
+
+    //! ask the process to terminate and kill it if it's still alive after TerminateTimeoutMs
+    static void stop(QProcess *process);
+
+signals:
+    void restartDue(QString moduleName);
+
+private:
+    struct Record
+    {
+        int restarts = 0;
+        int backoffMs = InitialBackoffMs;
+        bool running = false;
+        bool suspended = false;
+        QElapsedTimer uptime;
+        QList<qint64> recentRestarts; //!< msecs since epoch, within BudgetWindowMs
+        QTimer *timer = nullptr;
+    };
+
+    QHash<QString, Record> m_records;
+};
+
+#endif // MODULESUPERVISOR_H
@@ -0,0 +1,98 @@
+#include "ModuleWarmPool.h"
+
+#include <QFile>
+#include <QDateTime>
+#include <algorithm>
+
+#include "Tracer.h"
+
+ModuleWarmPool::ModuleWarmPool(QObject *parent) : QObject(parent)
+{
+
+}
+
+void ModuleWarmPool::loadOptions(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return;
+
+    while (!file.atEnd())
+    {
+        QStringList pair = QString::fromUtf8(file.readLine()).simplified().split(' ');
+        if (pair.size() != 2)
+            continue;
+
+        int value = pair[1].trimmed().toInt();
+        if (pair[0] == "capacity")
+            setCapacity(value);
+        else if (pair[0] == "idleTimeout")
+            setIdleTimeout(value * 1000);
+    }
+}
+
+void ModuleWarmPool::setCapacity(int capacity)
+{
+    m_capacity = qMax(0, capacity);
+
+    // the longest idle modules go first
+    while (m_parked.size() > m_capacity)
+    {
+        QString oldest = byRecentUse(m_parked.keys()).last();
+        forget(oldest);
+        emit expired(oldest);
+    }
+}
+
+bool ModuleWarmPool::park(const QString &moduleName)
+{
+    if (isParked(moduleName))
+        return true;
+    if (isFull())
+        return false;
+
+    auto timer = new QTimer(this);
+    timer->setSingleShot(true);
+    connect(timer, &QTimer::timeout, this, [=]()
+    {
+        XO_TRACE_INFO(Loader, "warm module expired", moduleName);
+        forget(moduleName);
+        emit expired(moduleName);
+    });
+    if (m_idleTimeoutMs > 0)
+        timer->start(m_idleTimeoutMs);
+
+    m_parked[moduleName] = timer;
+    XO_TRACE_DEBUG(Loader, "module parked", moduleName, m_parked.size());
+    return true;
+}
+
+bool ModuleWarmPool::take(const QString &moduleName)
+{
+    m_lastUse[moduleName] = QDateTime::currentMSecsSinceEpoch();
+
+    QTimer *timer = m_parked.take(moduleName);
+    if (!timer)
+        return false;
+
+    timer->deleteLater();
+    XO_TRACE_DEBUG(Loader, "warm module taken", moduleName);
+    return true;
+}
+
+void ModuleWarmPool::forget(const QString &moduleName)
+{
+    QTimer *timer = m_parked.take(moduleName);
+    if (timer)
+        timer->deleteLater();
+}
+
+QStringList ModuleWarmPool::byRecentUse(const QStringList &moduleNames) const
+{
+    QStringList result = moduleNames;
+    std::stable_sort(result.begin(), result.end(), [this](const QString &a, const QString &b)
+    {
+        return m_lastUse.value(a, 0) > m_lastUse.value(b, 0);
+    });
+    return result;
+}
@@ -0,0 +1,57 @@
+#ifndef MODULEWARMPOOL_H
+#define MODULEWARMPOOL_H
+
+#include <QHash>
+#include <QTimer>
+#include <QObject>
+#include <QStringList>
+#include "xoCore_global.h"
+
+//! COLD modules kept running while nothing uses them.
+//! A parked module is started, connected and enumerated, so creating its first component
+//! costs one round-trip instead of a process start. Parked modules are stopped after
+//! being idle for idleTimeout(); the pool never holds more than capacity() of them.
+//! Options are read from the "ModuleWarmPool" file next to the application:
+//! "capacity <count>" and "idleTimeout <seconds>" lines.
+class XOCORESHARED_EXPORT ModuleWarmPool : public QObject
+{
+    Q_OBJECT
+public:
+    static const int DefaultIdleTimeoutMs = 600000;
+
+    explicit ModuleWarmPool(QObject *parent = nullptr);
+
+    void loadOptions(const QString &path);
+
+    //! 0 disables the pool
+    int capacity() const { return m_capacity; }
+    void setCapacity(int capacity);
+    int idleTimeout() const { return m_idleTimeoutMs; }
+    void setIdleTimeout(int ms) { m_idleTimeoutMs = ms; }
+
+    bool isFull() const { return m_parked.size() >= m_capacity; }
+    bool isParked(const QString &moduleName) const { return m_parked.contains(moduleName); }
+    QStringList parked() const { return m_parked.keys(); }
+
+    //! keep the running module instead of stopping it, false if the pool is full
+    bool park(const QString &moduleName);
+    //! the module is used now, true if it was parked
+    bool take(const QString &moduleName);
+    //! the module stopped by itself
+    void forget(const QString &moduleName);
+
+    //! names ordered by the last use, most recent first, never used ones keep their order at the end
+    QStringList byRecentUse(const QStringList &moduleNames) const;
+
+signals:
+    //! idle for too long: the module is to be stopped
+    void expired(QString moduleName);
+
+private:
+    int m_capacity = 0;
+    int m_idleTimeoutMs = DefaultIdleTimeoutMs;
+    QHash<QString, QTimer*> m_parked;
+    QHash<QString, qint64> m_lastUse;
+};
+
+#endif // MODULEWARMPOOL_H
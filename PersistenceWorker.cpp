@@ -0,0 +1,115 @@
+#include "PersistenceWorker.h"
+
+#include <QSaveFile>
+#include <QFileInfo>
+#include <QDebug>
+
+#include "fileutilities.h"
+
+PersistenceWorker *PersistenceWorker::instance = nullptr;
+
+PersistenceWorker::PersistenceWorker(QObject *parent) : QThread(parent)
+{
+    start(QThread::LowPriority);
+}
+
+PersistenceWorker::~PersistenceWorker()
+{
+    {
+        QMutexLocker lock(&m_mutex);
+        m_stop = true;
+        m_condition.wakeOne();
+    }
+    wait();
+}
+
+PersistenceWorker *PersistenceWorker::Instance()
+{
+    if (!instance) instance = new PersistenceWorker();
+
+    return instance;
+}
+
+void PersistenceWorker::removeWorker()
+{
+    if (instance)
+    {
+        delete instance;
+        instance = nullptr;
+    }
+}
+
+QFuture<bool> PersistenceWorker::enqueue(const QString &path, Job job)
+{
+    QMutexLocker lock(&m_mutex);
+
+    auto it = m_tasks.find(path);
+    if (it != m_tasks.end())
+    {
+        // not started yet: newer content wins, waiting callers get its result
+        it->job = job;
+        return it->result.future();
+    }
+
+    Task task;
+    task.job = job;
+    task.result.reportStarted();
+    m_tasks.insert(path, task);
+    m_order.enqueue(path);
+    m_condition.wakeOne();
+
+    return task.result.future();
+}
+
+QFuture<bool> PersistenceWorker::writeFile(const QString &path, const QByteArray &data)
+{
+    return enqueue(path, [=]() { return writeFileNow(path, data); });
+}
+
+bool PersistenceWorker::writeFileNow(const QString &path, const QByteArray &data)
+{
+    FileUtilities::createIfNotExists(QFileInfo(path).absolutePath() + "/");
+
+    QFile existing(path);
+    if (existing.exists() && !existing.isWritable())
+    {
+        auto p = existing.permissions();
+        p.setFlag(QFile::WriteOwner, true);
+        p.setFlag(QFile::WriteUser, true);
+        existing.setPermissions(p);
+    }
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        qDebug() << "[PersistenceWorker] cannot write into" << path;
+        return false;
+    }
+
+    file.write(data);
+    return file.commit();
+}
+
+void PersistenceWorker::run()
+{
+    forever
+    {
+        Task task;
+
+        {
+            QMutexLocker lock(&m_mutex);
+            while (m_order.isEmpty() && !m_stop)
+                m_condition.wait(&m_mutex);
+
+            // queued jobs are finished before stopping
+            if (m_order.isEmpty())
+                break;
+
+            task = m_tasks.take(m_order.dequeue());
+        }
+
+        bool ok = task.job ? task.job() : false;
+        task.result.reportResult(ok);
+        task.result.reportFinished();
+    }
+}
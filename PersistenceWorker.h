@@ -0,0 +1,57 @@
+#ifndef PERSISTENCEWORKER_H
+#define PERSISTENCEWORKER_H
+
+#include <functional>
+
+#include <QHash>
+#include <QMutex>
+#include <QQueue>
+#include <QThread>
+#include <QFuture>
+#include <QFutureInterface>
+#include <QWaitCondition>
+#include "xoCore_global.h"
+
+//! Background thread for everything that writes schemes and configs to disk.
+//! Jobs are queued by target path: a job for a path that is still waiting replaces
+//! the waiting one, so repeated writes of the same file collapse into a single write.
+//! Jobs run one by one in the order their paths were first queued.
+class XOCORESHARED_EXPORT PersistenceWorker : public QThread
+{
+    Q_OBJECT
+public:
+    typedef std::function<bool()> Job;
+
+    static PersistenceWorker *Instance();
+    //! finishes queued jobs and stops the thread
+    static void removeWorker();
+
+    QFuture<bool> enqueue(const QString &path, Job job);
+    QFuture<bool> writeFile(const QString &path, const QByteArray &data);
+
+    //! write the file atomically (for use inside jobs)
+    static bool writeFileNow(const QString &path, const QByteArray &data);
+
+protected:
+    void run() override;
+
+private:
+    explicit PersistenceWorker(QObject *parent = nullptr);
+    ~PersistenceWorker() override;
+
+    static PersistenceWorker *instance;
+
+    struct Task
+    {
+        Job job;
+        QFutureInterface<bool> result;
+    };
+
+    QMutex m_mutex;
+    QWaitCondition m_condition;
+    QHash<QString, Task> m_tasks;
+    QQueue<QString> m_order;
+    bool m_stop = false;
+};
+
+#endif // PERSISTENCEWORKER_H
@@ -2,7 +2,13 @@
 
 #include <QDir>
 #include <QJsonDocument>
+#include <QMetaMethod>
 #include <QPluginLoader>
+#include <QFutureWatcher>
+#include <QtConcurrent/QtConcurrent>
+
+#include "StartupProfiler.h"
+#include "Module/InProcessTransport.h"
 
 PluginManager *PluginManager::instance = nullptr;
 
@@ -57,13 +63,61 @@ PluginManager* PluginManager::Instance()
 ModuleBaseONB* PluginManager::load(QString moduleName, QString path)
 {
     QPluginLoader loader(path);
-    auto plugin = loader.instance();
+    return attach(moduleName, loader.instance());
+}
+
+void PluginManager::loadAsync(QString moduleName, QString path)
+{
+    // loading and relocating the library is the slow part, the instance is still created here
+    if (m_loading.contains(moduleName) || factories.contains(moduleName)) return;
+    m_loading << moduleName;
+
+    auto loader = new QPluginLoader(path, this);
+    auto watcher = new QFutureWatcher<bool>(this);
+    connect(watcher, &QFutureWatcher<bool>::finished, this, [=]()
+    {
+        XO_PROFILE_SCOPE("instantiate plugin", moduleName);
+        m_loading.remove(moduleName);
+        ModuleBaseONB *module = watcher->result() ? attach(moduleName, loader->instance()) : nullptr;
+        // the loader is kept to unload the plugin later
+        if (module)
+            m_loaders[moduleName] = loader;
+        else
+            loader->deleteLater();
+        watcher->deleteLater();
+        emit pluginLoaded(moduleName, module);
+    });
+    watcher->setFuture(QtConcurrent::run([=]()
+    {
+        XO_PROFILE_SCOPE("load plugin library", moduleName);
+        return loader->load();
+    }));
+}
+
+void PluginManager::unload(QString moduleName)
+{
+    QPluginLoader *loader = m_loaders.take(moduleName);
+    if (!loader) return;
+
+    // the instance is the root component of the loader, unload() deletes it
+    factories.remove(moduleName);
+    loader->unload();
+    loader->deleteLater();
+}
+
+ModuleBaseONB *PluginManager::attach(QString moduleName, QObject *plugin)
+{
     if(!plugin) return nullptr;
 
     auto pluginModule = qobject_cast<ModuleBaseAppONB*>(plugin);
     if (pluginModule)
     {
-        pluginModule->tryConnect();
+        // without the loopback socket if the plugin and a listener support it
+        static const QMetaMethod inProcessSignal = QMetaMethod::fromSignal(&PluginManager::inProcessModule);
+        if (InProcessTransport::isSupported(pluginModule) && isSignalConnected(inProcessSignal))
+            emit inProcessModule(moduleName, pluginModule);
+        else
+            pluginModule->tryConnect();
         factories[moduleName] = pluginModule;
     }
 
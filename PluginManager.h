@@ -2,7 +2,9 @@
 #define PLUGINMANAGER_H
 
 #include "ModuleBaseAppONB.h"
+#include <QSet>
 #include <QObject>
+#include <QPluginLoader>
 #include "xoCore_global.h"
 
 class XOCORESHARED_EXPORT PluginManager : public QObject
@@ -15,13 +17,30 @@ public:
     static PluginManager *Instance();
     static void removeManager();
     ModuleBaseONB *load(QString moduleName, QString path);
+    //! resolve the library on the thread pool, pluginLoaded() follows in this thread
+    void loadAsync(QString moduleName, QString path);
+    //! delete the instance and unload the library of a plugin loaded with loadAsync()
+    void unload(QString moduleName);
+    bool isLoaded(QString moduleName) const { return factories.contains(moduleName); }
+    bool isLoading(QString moduleName) const { return m_loading.contains(moduleName); }
 
     QHash<QString, ModuleBaseAppONB*> factories;
     QJsonObject parseComponents();
     void createConfigList(const QJsonObject& in_obj);
 
+signals:
+    //! module is nullptr if the plugin can't be loaded
+    void pluginLoaded(QString moduleName, ModuleBaseONB *module);
+    //! the plugin exchanges packets directly (see InProcessTransport), it isn't connected by itself
+    void inProcessModule(QString moduleName, QObject *endpoint);
+
 private:
     static PluginManager* instance;
+
+    QHash<QString, QPluginLoader*> m_loaders;
+    QSet<QString> m_loading;
+
+    ModuleBaseONB *attach(QString moduleName, QObject *plugin);
 };
 
 #endif // PLUGINMANAGER_H
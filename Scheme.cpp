@@ -4,11 +4,13 @@
 #include <QJsonDocument>
 #include <QJsonArray>
 #include <QJsonObject>
-#include <QTextStream>
 #include <QDebug>
 #include <QFileInfo>
-#include <QTextCodec>
+#include <QFutureWatcher>
 
+#include "SchemeCache.h"
+#include "SchemeJournal.h"
+#include "PersistenceWorker.h"
 #include "GlobalConsole.h"
 
 Scheme::Scheme(QObject* parent) : QObject(parent)
@@ -26,6 +28,142 @@ Scheme::~Scheme()
     clear();
 }
 
+void Scheme::openJournal(const QString &path, int existingRecords)
+{
+    // schemes that are never bound to a file (e.g. built from JSON) have no journal thread
+    if (!m_journal)
+    {
+        m_journal = new SchemeJournal(this);
+
+        m_compactionTimer = new QTimer(this);
+        connect(m_compactionTimer, &QTimer::timeout, this, [=]() { if (m_journal->recordCount() > 0) compact(); });
+        m_compactionTimer->start(JournalCompactionIntervalMs);
+    }
+
+    m_journal->open(path, existingRecords);
+}
+
+void Scheme::journal(const QJsonObject &record)
+{
+    if (!m_journal || !m_journal->isOpen())
+        return;
+
+    m_journal->append(record);
+
+    if (m_journal->recordCount() >= JournalCompactionThreshold)
+        QTimer::singleShot(0, this, [=]() { if (m_journal->recordCount() >= JournalCompactionThreshold) compact(); });
+}
+
+void Scheme::compact()
+{
+    if (m_journal && m_journal->isOpen())
+        save(m_journal->schemePath());
+}
+
+void Scheme::autosave()
+{
+    // edits are already journaled, only a scheme without a journal needs to be written
+    if ((!m_journal || !m_journal->isOpen()) && !m_lastLoadedPath.isEmpty())
+        save(m_lastLoadedPath);
+}
+
+void Scheme::setDescription(QString desc)
+{
+    m_description = desc;
+
+    QJsonObject record;
+    record.insert("op", "description");
+    record.insert("description", desc);
+    journal(record);
+}
+
+void Scheme::updateComponent(ComponentInfo *component)
+{
+    if (!component || components.value(component->name) != component)
+        return;
+
+    QJsonObject record;
+    record.insert("op", "updateComponent");
+    record.insert("component", component->toJsonObject());
+    journal(record);
+
+    notifyComponentsUpdated();
+}
+
+bool Scheme::applyJournalRecord(const QJsonObject &record)
+{
+    // records must be idempotent: a crash between snapshot and truncation replays them over a snapshot that has them.
+    // A rename whose effect is present finds no old name or finds the new one taken, and is skipped
+    QString op = record.value("op").toString();
+
+    if (op == "addComponent" || op == "updateComponent")
+    {
+        QJsonObject object = record.value("component").toObject();
+        auto info = ComponentInfo::fromJson(object);
+        if (!info)
+            return false;
+
+        auto existing = components.value(info->name, nullptr);
+        if (!existing)
+        {
+            addComponent(info);
+            return true;
+        }
+
+        if (existing->type != info->type || existing->parentModule != info->parentModule)
+        {
+            delete info;
+            return false;
+        }
+
+        existing->enabled = info->enabled;
+        existing->visualX = info->visualX;
+        existing->visualY = info->visualY;
+        existing->settings = info->settings;
+        existing->inputsWithType = info->inputsWithType;
+        existing->outputsWithType = info->outputsWithType;
+        delete info;
+        notifyComponentsUpdated();
+        return true;
+    }
+    else if (op == "removeComponent")
+    {
+        return removeComponentByName(record.value("name").toString());
+    }
+    else if (op == "renameComponent")
+    {
+        return renameComponentByName(record.value("name").toString(), record.value("newName").toString());
+    }
+    else if (op == "addConnection")
+    {
+        QJsonObject object = record.value("connection").toObject();
+        auto connection = ComponentConnection::fromJson(object);
+        if (connectionsHash.contains(connection->compoundString()))
+        {
+            delete connection;
+            return false;
+        }
+        addConnection(connection);
+        return true;
+    }
+    else if (op == "removeConnection")
+    {
+        auto connection = connectionsHash.value(record.value("key").toString(), nullptr);
+        if (!connection)
+            return false;
+        removeConnection(connection);
+        delete connection;
+        return true;
+    }
+    else if (op == "description")
+    {
+        setDescription(record.value("description").toString());
+        return true;
+    }
+
+    return false;
+}
+
 void Scheme::fromJson(const QJsonObject& in_obj)
 {
     QJsonArray arrayComponents = in_obj.value("components").toArray();
@@ -35,8 +173,7 @@ void Scheme::fromJson(const QJsonObject& in_obj)
         auto compInfo = ComponentInfo::fromJson(object);
         if (compInfo == nullptr) continue;
 
-        components.insert(compInfo->name, compInfo);
-        componentCountByModule[compInfo->parentModule]++;
+        insertComponent(compInfo);
     }
 
     QJsonArray arrayConnections = in_obj.value("connections").toArray();
@@ -45,17 +182,12 @@ void Scheme::fromJson(const QJsonObject& in_obj)
         QJsonObject object = value.toObject();
         ComponentConnection* connection = ComponentConnection::fromJson(object);
         if (connection != nullptr)
-        {
-            connections << connection;
-            connectionsHash[connection->compoundString()] = connection;
-            connectionsByOutput[connection->outputComponentName + "_" + connection->outputName].append(connection);
-            connectionsByInput[connection->inputComponentName + "_" + connection->inputName].append(connection);
-        }
+            insertConnection(connection);
     }
     m_description = in_obj.value("description").toString().isEmpty()? "" : in_obj.value("description").toString();
 
-    emit componentsUpdated();
-    emit connectionsUpdated();
+    notifyComponentsUpdated();
+    notifyConnectionsUpdated();
 }
 
 QJsonObject Scheme::toJson() const
@@ -84,48 +216,48 @@ QString Scheme::getLastLoadedPath()
     return m_lastLoadedPath;
 }
 
-void Scheme::save(QString path)
+QFuture<bool> Scheme::save(QString path)
 {
+    // only the JSON tree is built here, formatting and writing happen on the persistence thread
     QJsonObject root = toJson();
 
-    QJsonDocument document;
-    document.setObject(root);
-
-    QFile file(path);    
-
-    if (!file.isWritable())
-    {
-        GlobalConsole::writeLine("Making scheme file writable " + path);
-        auto p = file.permissions();
-        p.setFlag(QFile::WriteOwner, true);
-
-        file.setPermissions(p);
-    }
-
-    if (!file.open(QIODevice::WriteOnly))
+    bool sameJournal = m_journal && m_journal->isOpen() && m_journal->schemePath() == path;
+    if (!sameJournal)
     {
-        GlobalConsole::writeLine("Making scheme file writable again " + path);
-        auto p = file.permissions();
-        p.setFlag(QFile::WriteOwner, true);
-        p.setFlag(QFile::WriteOther, true);
-        p.setFlag(QFile::WriteGroup, true);
-        p.setFlag(QFile::WriteUser, true);
-        file.open(QIODevice::WriteOnly);
+        SchemeJournal::remove(path);
+        openJournal(path);
     }
+    qint64 mark = m_journal->mark();
+    int generation = m_journal->generation();
+    m_journal->resetRecordCount();
 
+    m_lastLoadedPath = path;
 
-    if (file.isOpen())
+    QFuture<bool> result = PersistenceWorker::Instance()->enqueue(path, [=]()
     {
-        QTextStream stream(&file);
-        stream.setCodec(QTextCodec::codecForName("UTF-8"));
-        stream << document.toJson();
-
-        m_lastLoadedPath = path;
-    }
-    else
+        // the compiled cache would be stale, it is rebuilt on the next load
+        SchemeCache::remove(path);
+        return PersistenceWorker::writeFileNow(path, QJsonDocument(root).toJson());
+    });
+
+    // records up to the mark are in the snapshot once it is on disk
+    auto watcher = new QFutureWatcher<bool>(this);
+    connect(watcher, &QFutureWatcher<bool>::finished, this, [=]()
     {
-        GlobalConsole::writeLine("Cannot write scheme into " + path);
-    }
+        if (watcher->result())
+        {
+            if (m_journal && m_journal->schemePath() == path)
+                m_journal->truncateBefore(mark, generation);
+        }
+        else
+        {
+            GlobalConsole::writeLine("Cannot write scheme into " + path);
+        }
+        watcher->deleteLater();
+    });
+    watcher->setFuture(result);
+
+    return result;
 }
 
 bool Scheme::load(QString path)
@@ -138,14 +270,34 @@ bool Scheme::load(QString path)
     if (!file.exists())
         return false;
 
-    if (!file.open(QIODevice::ReadOnly))
-        return false;
+    beginUpdate();
+
+    if (SchemeCache::load(path, this))
+    {
+        notifyComponentsUpdated();
+        notifyConnectionsUpdated();
+    }
+    else
+    {
+        if (!file.open(QIODevice::ReadOnly))
+        {
+            endUpdate();
+            return false;
+        }
+
+        auto content = file.readAll();
+        QJsonDocument document = QJsonDocument::fromJson(content);
+        fromJson(document.object());
 
-    auto content = file.readAll();
-    QJsonDocument document = QJsonDocument::fromJson(content);
-    fromJson(document.object());
+        file.close();
 
-    file.close();
+        SchemeCache::write(path, this);
+    }
+
+    int replayed = SchemeJournal::replay(path, this);
+    openJournal(path, replayed);
+
+    endUpdate();
 
     m_lastLoadedPath = path;
 
@@ -155,29 +307,189 @@ bool Scheme::load(QString path)
     return true;
 }
 
-void Scheme::addComponent(ComponentInfo *component)
+QString Scheme::componentKey(const QString &componentName, const QString &componentType, const QString &moduleName)
+{
+    return moduleName.toLower() + '\n' + componentType.toLower() + '\n' + componentName.toLower();
+}
+
+QString Scheme::outputKey(const ComponentConnection *connection)
+{
+    return connection->outputComponentName + "_" + connection->outputName;
+}
+
+QString Scheme::inputKey(const ComponentConnection *connection)
+{
+    return connection->inputComponentName + "_" + connection->inputName;
+}
+
+void Scheme::insertComponent(ComponentInfo *component)
 {
     componentCountByModule[component->parentModule]++;
     components.insert(component->name, component);
-    emit componentsUpdated();    
+    m_componentsByKey.insert(componentKey(component->name, component->type, component->parentModule), component);
 }
 
-void Scheme::addConnection(ComponentConnection *connection)
+void Scheme::indexConnectionComponents(ComponentConnection *connection)
 {
+    QString output = connection->outputComponentName.toLower();
+    QString input = connection->inputComponentName.toLower();
+    m_connectionsByComponent[output].append(connection);
+    if (input != output)
+        m_connectionsByComponent[input].append(connection);
+}
+
+void Scheme::unindexConnectionComponents(ComponentConnection *connection)
+{
+    auto removeFromComponent = [this, connection](const QString &key)
+    {
+        auto it = m_connectionsByComponent.find(key);
+        if (it == m_connectionsByComponent.end())
+            return;
+        it->removeOne(connection);
+        if (it->isEmpty())
+            m_connectionsByComponent.erase(it);
+    };
+
+    QString output = connection->outputComponentName.toLower();
+    QString input = connection->inputComponentName.toLower();
+    removeFromComponent(output);
+    if (input != output)
+        removeFromComponent(input);
+}
+
+void Scheme::insertConnection(ComponentConnection *connection, bool indexChannels)
+{
+    connection->schemeIndex = connections.size();
     connections.append(connection);
     connectionsHash[connection->compoundString()] = connection;
-    connectionsByOutput[connection->outputComponentName + "_" + connection->outputName].append(connection);
-    connectionsByInput[connection->inputComponentName + "_" + connection->inputName].append(connection);
-    emit connectionsUpdated();
+
+    if (indexChannels)
+    {
+        connectionsByOutput[outputKey(connection)].append(connection);
+        connectionsByInput[inputKey(connection)].append(connection);
+    }
+
+    indexConnectionComponents(connection);
 }
 
-void Scheme::removeConnection(ComponentConnection *connection)
+void Scheme::unindexConnectionChannels(ComponentConnection *connection)
 {
-    connections.removeAt(connections.indexOf(connection));
     connectionsHash.remove(connection->compoundString());
-    connectionsByOutput.remove(connection->outputComponentName + "_" + connection->outputName);
-    connectionsByInput.remove(connection->inputComponentName + "_" + connection->inputName);
-    emit connectionsUpdated();
+
+    auto removeFromBucket = [connection](QHash<QString, QList<ComponentConnection*>> &index, const QString &key)
+    {
+        auto it = index.find(key);
+        if (it == index.end())
+            return;
+        it->removeOne(connection);
+        if (it->isEmpty())
+            index.erase(it);
+    };
+
+    removeFromBucket(connectionsByOutput, outputKey(connection));
+    removeFromBucket(connectionsByInput, inputKey(connection));
+}
+
+void Scheme::indexConnectionChannels(ComponentConnection *connection)
+{
+    connectionsHash[connection->compoundString()] = connection;
+    connectionsByOutput[outputKey(connection)].append(connection);
+    connectionsByInput[inputKey(connection)].append(connection);
+}
+
+void Scheme::takeConnection(ComponentConnection *connection)
+{
+    int idx = connection->schemeIndex;
+    if (idx < 0 || idx >= connections.size() || connections.at(idx) != connection)
+        return;
+
+    // swap with the last one to keep removal O(1), handles stay valid
+    ComponentConnection *last = connections.last();
+    connections[idx] = last;
+    last->schemeIndex = idx;
+    connections.removeLast();
+    connection->schemeIndex = -1;
+
+    unindexConnectionChannels(connection);
+    unindexConnectionComponents(connection);
+}
+
+void Scheme::notifyComponentsUpdated()
+{
+    if (m_updateDepth)
+        m_componentsDirty = true;
+    else
+        emit componentsUpdated();
+}
+
+void Scheme::notifyConnectionsUpdated()
+{
+    if (m_updateDepth)
+        m_connectionsDirty = true;
+    else
+        emit connectionsUpdated();
+}
+
+void Scheme::beginUpdate()
+{
+    m_updateDepth++;
+}
+
+void Scheme::endUpdate()
+{
+    if (m_updateDepth == 0 || --m_updateDepth > 0)
+        return;
+
+    if (m_componentsDirty)
+    {
+        m_componentsDirty = false;
+        emit componentsUpdated();
+    }
+
+    if (m_connectionsDirty)
+    {
+        m_connectionsDirty = false;
+        emit connectionsUpdated();
+    }
+}
+
+void Scheme::addComponent(ComponentInfo *component)
+{
+    insertComponent(component);
+
+    QJsonObject record;
+    record.insert("op", "addComponent");
+    record.insert("component", component->toJsonObject());
+    journal(record);
+
+    notifyComponentsUpdated();
+}
+
+void Scheme::addConnection(ComponentConnection *connection)
+{
+    insertConnection(connection);
+
+    QJsonObject record;
+    record.insert("op", "addConnection");
+    record.insert("connection", connection->toJsonObject());
+    journal(record);
+
+    notifyConnectionsUpdated();
+}
+
+void Scheme::removeConnection(ComponentConnection *connection)
+{
+    if (connection->schemeIndex < 0)
+        return;
+
+    takeConnection(connection);
+
+    QJsonObject record;
+    record.insert("op", "removeConnection");
+    record.insert("key", connection->compoundString());
+    journal(record);
+
+    notifyConnectionsUpdated();
 }
 
 bool Scheme::containsModuleName(QString name)
@@ -192,97 +504,107 @@ bool Scheme::containsComponentName(QString name)
 
 bool Scheme::renameComponentByName(QString componentName,QString newName)
 {
-    if (components.contains(componentName))
-    {
-        auto component = components[componentName];        
-        components.remove(componentName);
-        component->name = newName;
-        components.insert(newName, component);
+    // renaming onto another component would silently drop it
+    if (!components.contains(componentName) || (newName != componentName && components.contains(newName)))
+        return false;
 
-        bool anyConnections = false;
-        for(int i = connections.count()-1; i>=0; i--)
-        {
-            auto conn = connections.at(i);
-            if (conn->inputComponentName.compare(componentName, Qt::CaseInsensitive) == 0)
-            {
-                conn->inputComponentName = newName;
-                anyConnections = true;
-            }
-
-            if (conn->outputComponentName.compare(componentName, Qt::CaseInsensitive) == 0)
-            {
-                conn->outputComponentName = newName;
-                anyConnections = true;
-            }
-        }
+    auto component = components.take(componentName);
+    m_componentsByKey.remove(componentKey(component->name, component->type, component->parentModule), component);
+    component->name = newName;
+    components.insert(newName, component);
+    m_componentsByKey.insert(componentKey(component->name, component->type, component->parentModule), component);
+
+    // endpoints are matched regardless of case, as they always were
+    QList<ComponentConnection*> adjacent = m_connectionsByComponent.value(componentName.toLower());
+    for (auto connection : adjacent)
+    {
+        unindexConnectionChannels(connection);
+        unindexConnectionComponents(connection);
 
-        emit componentsUpdated();
+        if (connection->inputComponentName.compare(componentName, Qt::CaseInsensitive) == 0)
+            connection->inputComponentName = newName;
 
-        if (anyConnections) emit connectionsUpdated();
+        if (connection->outputComponentName.compare(componentName, Qt::CaseInsensitive) == 0)
+            connection->outputComponentName = newName;
 
-        return true;
+        indexConnectionChannels(connection);
+        indexConnectionComponents(connection);
     }
-    return false;
+
+    QJsonObject record;
+    record.insert("op", "renameComponent");
+    record.insert("name", componentName);
+    record.insert("newName", newName);
+    journal(record);
+
+    notifyComponentsUpdated();
+
+    if (!adjacent.isEmpty()) notifyConnectionsUpdated();
+
+    return true;
 }
 
 
 bool Scheme::removeComponentByName(QString componentName)
 {
+    if (!components.contains(componentName))
+        return false;
+
     auto component = components.take(componentName);
+    m_componentsByKey.remove(componentKey(component->name, component->type, component->parentModule), component);
+
     componentCountByModule[component->parentModule]--;
     if(componentCountByModule[component->parentModule] == 0) componentCountByModule.remove(component->parentModule);
 
-    auto removeConnections = [=](QString componentName, QString channelName, QHash<QString, QList<ComponentConnection*>>& connections)
-    {
-        QString key = componentName + "_" + channelName;
-        if(connections.contains(key))
-            for(auto& connection : connections[key])
-                removeConnection(connection);
-    };
-
-    for(auto& input : component->inputsWithType.keys())
-        removeConnections(componentName, input, connectionsByInput);
+    // the bucket may hold components differing only by case
+    for (auto connection : m_connectionsByComponent.value(componentName.toLower()))
+        if (connection->outputComponentName == componentName || connection->inputComponentName == componentName)
+            takeConnection(connection);
 
-    for(auto& output : component->outputsWithType.keys())
-        removeConnections(componentName, output, connectionsByOutput);
+    // connections of the component are dropped on replay the same way
+    QJsonObject record;
+    record.insert("op", "removeComponent");
+    record.insert("name", componentName);
+    journal(record);
 
-    emit componentsUpdated();
-    emit connectionsUpdated();
+    notifyComponentsUpdated();
+    notifyConnectionsUpdated();
 
     return true;
 }
 
 ComponentInfo *Scheme::componentInfoByNameTypeModule(QString componentName, QString componentType, QString moduleName)
 {
-    for(auto component : components)
-    {
-        if (component->name.compare(componentName, Qt::CaseInsensitive) == 0 &&
-            component->type.compare(componentType, Qt::CaseInsensitive) == 0 &&
-            component->parentModule.compare(moduleName, Qt::CaseInsensitive) == 0)
-        {
+    QList<ComponentInfo*> candidates = m_componentsByKey.values(componentKey(componentName, componentType, moduleName));
+    for (auto component : candidates)
+        if (component->name == componentName && component->type == componentType && component->parentModule == moduleName)
             return component;
-        }
-    }
-    return nullptr;
+    return candidates.isEmpty() ? nullptr : candidates.last();
 }
 
 void Scheme::clear(bool sendSignals)
 {
+    if (m_journal)
+        m_journal->close();
+
     qDeleteAll(connections);
 
     components.clear();
+    componentCountByModule.clear();
     connections.clear();
     connectionsHash.clear();
     connectionsByOutput.clear();
     connectionsByInput.clear();
+    m_connectionsByComponent.clear();
+    m_componentsByKey.clear();
 
     m_lastLoadedPath = "";
     m_description = "";
 
     if (sendSignals)
     {
-        emit componentsUpdated();
-        emit connectionsUpdated();
+        notifyComponentsUpdated();
+        notifyConnectionsUpdated();
         emit cleared();
     }
 }
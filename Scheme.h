@@ -2,10 +2,14 @@
 #define SCHEME_H
 
 #include <QList>
+#include <QTimer>
+#include <QFuture>
 #include "Data/ComponentInfo.h"
 #include "Data/ComponentConnection.h"
 #include "xoCore_global.h"
 
+class SchemeJournal;
+
 class XOCORESHARED_EXPORT Scheme : public QObject
 {
     Q_OBJECT
@@ -17,14 +21,27 @@ public:
 
     QString name;
 
-    void save(QString path);
+    //! number of journaled edits that triggers compaction into a full snapshot
+    static const int JournalCompactionThreshold = 1000;
+    static const int JournalCompactionIntervalMs = 5 * 60 * 1000;
+
+    //! write a full snapshot in the background, the future reports whether it reached the disk
+    QFuture<bool> save(QString path);
     bool load(QString path);
+    //! persist pending edits: they are journaled already, so this only writes schemes that have no file yet
+    void autosave();
 
     void fromJson(const QJsonObject& in_obj);
-    void setDescription(QString desc) {m_description = desc;}
+    void setDescription(QString desc);
     QString getDescription() {return m_description;}
 
+    //! defer componentsUpdated()/connectionsUpdated() until the matching endUpdate() (for bulk edits)
+    void beginUpdate();
+    void endUpdate();
+
     void addComponent(ComponentInfo *comp);
+    //! record changes made to settings, position or channels of a component of this scheme
+    void updateComponent(ComponentInfo *comp);
     void addConnection(ComponentConnection *conn);
     void removeConnection(ComponentConnection *connection);
 
@@ -50,10 +67,46 @@ public:
 
     QString getLastLoadedPath();
 
+    //! apply one edit record of the journal, returns false if it had no effect
+    bool applyJournalRecord(const QJsonObject &record);
+
 protected:
     QString m_lastLoadedPath = "";
     QString m_description = "";
 
+    //! all connections touching a component (as input or output), keyed by lowercase component name
+    QHash<QString, QList<ComponentConnection*>> m_connectionsByComponent;
+    //! case-insensitive (module, type, name) index, components differing only by case share a key
+    QMultiHash<QString, ComponentInfo*> m_componentsByKey;
+
+    SchemeJournal *m_journal = nullptr;
+    QTimer *m_compactionTimer = nullptr;
+
+    void openJournal(const QString &path, int existingRecords = 0);
+    void journal(const QJsonObject &record);
+    void compact();
+
+    int m_updateDepth = 0;
+    bool m_componentsDirty = false;
+    bool m_connectionsDirty = false;
+
+    static QString componentKey(const QString &componentName, const QString &componentType, const QString &moduleName);
+    static QString outputKey(const ComponentConnection *connection);
+    static QString inputKey(const ComponentConnection *connection);
+
+    void insertComponent(ComponentInfo *component);
+    void insertConnection(ComponentConnection *connection, bool indexChannels = true);
+    void indexConnectionComponents(ComponentConnection *connection);
+    void unindexConnectionComponents(ComponentConnection *connection);
+    void takeConnection(ComponentConnection *connection);
+    void indexConnectionChannels(ComponentConnection *connection);
+    void unindexConnectionChannels(ComponentConnection *connection);
+
+    void notifyComponentsUpdated();
+    void notifyConnectionsUpdated();
+
+    friend class SchemeCache;
+
 signals:
     void connectionsUpdated();
     void componentsUpdated();
@@ -0,0 +1,487 @@
+#include "SchemeCache.h"
+#include "Scheme.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QJsonDocument>
+#include <QCryptographicHash>
+
+#include "GlobalConsole.h"
+
+const QString SchemeCache::FileExtensionCacheDot = ".cache";
+
+namespace
+{
+    const char Magic[4] = {'X', 'O', 'S', 'C'};
+    const quint32 Version = 3;
+    const quint32 NoString = 0xFFFFFFFF;
+
+    struct Header
+    {
+        char magic[4];
+        quint32 version;
+        qint64 sourceMtime;
+        qint64 sourceSize;
+        char sourceHash[16];
+
+        quint32 stringCount;
+        quint32 stringOffset;
+        quint32 stringDataOffset;
+        quint32 componentCount;
+        quint32 componentOffset;
+        quint32 portCount;
+        quint32 portOffset;
+        quint32 connectionCount;
+        quint32 connectionOffset;
+        quint32 outputAdjacencyCount;
+        quint32 outputAdjacencyOffset;
+        quint32 inputAdjacencyCount;
+        quint32 inputAdjacencyOffset;
+        quint32 adjacencyListCount;
+        quint32 adjacencyListOffset;
+        quint32 blobOffset;
+        quint32 blobSize;
+        quint32 description;
+    };
+
+    struct StringRecord
+    {
+        quint32 offset; //!< in QChars from the start of string data
+        quint32 length;
+    };
+
+    struct ComponentRecord
+    {
+        quint32 type;
+        quint32 name;
+        quint32 module;
+        quint32 enabled;
+        qint32 x;
+        qint32 y;
+        quint32 settingsOffset; //!< compact JSON in the blob area
+        quint32 settingsSize;
+        quint32 firstInput;
+        quint32 inputCount;
+        quint32 firstOutput;
+        quint32 outputCount;
+    };
+
+    struct PortRecord
+    {
+        quint32 name;
+        quint32 type;
+    };
+
+    struct ConnectionRecord
+    {
+        quint32 outputComponentName;
+        quint32 outputComponentType;
+        quint32 outputName;
+        quint32 outputType;
+        quint32 inputComponentName;
+        quint32 inputComponentType;
+        quint32 inputName;
+        quint32 inputType;
+        quint32 key; //!< ComponentConnection::compoundString()
+        qint32 RMIP;
+        quint32 enabled;
+        quint32 flags; //!< ConnectionFlags
+        quint32 filterOffset; //!< LinkFilter::Settings as compact JSON in the blob area, empty if none
+        quint32 filterSize;
+    };
+
+    enum ConnectionFlags
+    {
+        ConnectionDelta = 0x01
+    };
+
+    //! connections sharing "<component>_<channel>" are stored as a range in the adjacency list
+    struct AdjacencyRecord
+    {
+        quint32 key;
+        quint32 first;
+        quint32 count;
+    };
+
+    Q_STATIC_ASSERT(sizeof(Header) % 8 == 0);
+    Q_STATIC_ASSERT(sizeof(ComponentRecord) == 48);
+    Q_STATIC_ASSERT(sizeof(ConnectionRecord) == 56);
+
+    QByteArray sourceHash(const QByteArray &content)
+    {
+        return QCryptographicHash::hash(content, QCryptographicHash::Md5);
+    }
+
+    quint32 align8(quint32 value)
+    {
+        return (value + 7) & ~7u;
+    }
+
+    template <typename T>
+    void appendRecords(QByteArray &out, const QVector<T> &records)
+    {
+        out.append(reinterpret_cast<const char*>(records.constData()), records.size() * static_cast<int>(sizeof(T)));
+        out.append(QByteArray(static_cast<int>(align8(out.size()) - out.size()), '\0'));
+    }
+
+    class StringTable
+    {
+    public:
+        quint32 intern(const QString &str)
+        {
+            auto it = m_index.constFind(str);
+            if (it != m_index.constEnd())
+                return it.value();
+
+            quint32 idx = static_cast<quint32>(m_records.size());
+            m_records.append({static_cast<quint32>(m_data.size()), static_cast<quint32>(str.size())});
+            m_data.append(str);
+            m_index.insert(str, idx);
+            return idx;
+        }
+
+        const QVector<StringRecord> &records() const { return m_records; }
+        const QString &data() const { return m_data; }
+
+    private:
+        QHash<QString, quint32> m_index;
+        QVector<StringRecord> m_records;
+        QString m_data;
+    };
+
+    typedef QHash<QString, QList<ComponentConnection*>> ConnectionIndex;
+
+    void buildAdjacency(const ConnectionIndex &index, const QHash<const ComponentConnection*, quint32> &connectionIds,
+                        StringTable &strings, QVector<AdjacencyRecord> &adjacency, QVector<quint32> &list)
+    {
+        for (auto it = index.constBegin(); it != index.constEnd(); ++it)
+        {
+            AdjacencyRecord record;
+            record.key = strings.intern(it.key());
+            record.first = static_cast<quint32>(list.size());
+            record.count = 0;
+            for (auto connection : it.value())
+            {
+                if (!connectionIds.contains(connection)) continue;
+                list.append(connectionIds.value(connection));
+                record.count++;
+            }
+            adjacency.append(record);
+        }
+    }
+}
+
+QString SchemeCache::cachePath(const QString &schemePath)
+{
+    return schemePath + FileExtensionCacheDot;
+}
+
+void SchemeCache::remove(const QString &schemePath)
+{
+    QFile::remove(cachePath(schemePath));
+}
+
+bool SchemeCache::write(const QString &schemePath, const Scheme *scheme)
+{
+    QFile source(schemePath);
+    if (!source.open(QIODevice::ReadOnly))
+        return false;
+    QByteArray hash = sourceHash(source.readAll());
+    source.close();
+
+    QFileInfo sourceInfo(schemePath);
+
+    StringTable strings;
+    QVector<ComponentRecord> components;
+    QVector<PortRecord> ports;
+    QVector<ConnectionRecord> connections;
+    QVector<AdjacencyRecord> outputAdjacency, inputAdjacency;
+    QVector<quint32> adjacencyList;
+    QByteArray blob;
+
+    for (const auto component : scheme->components)
+    {
+        ComponentRecord record;
+        record.type = strings.intern(component->type);
+        record.name = strings.intern(component->name);
+        record.module = strings.intern(component->parentModule);
+        record.enabled = component->enabled;
+        record.x = component->visualX;
+        record.y = component->visualY;
+
+        QByteArray settings = QJsonDocument(component->settings).toJson(QJsonDocument::Compact);
+        record.settingsOffset = static_cast<quint32>(blob.size());
+        record.settingsSize = static_cast<quint32>(settings.size());
+        blob.append(settings);
+
+        record.firstInput = static_cast<quint32>(ports.size());
+        record.inputCount = static_cast<quint32>(component->inputsWithType.size());
+        for (auto it = component->inputsWithType.constBegin(); it != component->inputsWithType.constEnd(); ++it)
+            ports.append({strings.intern(it.key()), strings.intern(it.value())});
+
+        record.firstOutput = static_cast<quint32>(ports.size());
+        record.outputCount = static_cast<quint32>(component->outputsWithType.size());
+        for (auto it = component->outputsWithType.constBegin(); it != component->outputsWithType.constEnd(); ++it)
+            ports.append({strings.intern(it.key()), strings.intern(it.value())});
+
+        components.append(record);
+    }
+
+    QHash<const ComponentConnection*, quint32> connectionIds;
+    for (const auto connection : scheme->connections)
+    {
+        ConnectionRecord record;
+        record.outputComponentName = strings.intern(connection->outputComponentName);
+        record.outputComponentType = strings.intern(connection->outputComponentType);
+        record.outputName = strings.intern(connection->outputName);
+        record.outputType = strings.intern(connection->outputType);
+        record.inputComponentName = strings.intern(connection->inputComponentName);
+        record.inputComponentType = strings.intern(connection->inputComponentType);
+        record.inputName = strings.intern(connection->inputName);
+        record.inputType = strings.intern(connection->inputType);
+        record.key = strings.intern(connection->compoundString());
+        record.RMIP = connection->RMIP;
+        record.enabled = connection->isEnabled;
+        record.flags = connection->deltaMode ? ConnectionDelta : 0;
+
+        QByteArray filter = connection->filter.isEmpty() ? QByteArray() :
+                QJsonDocument(connection->filter.toJson()).toJson(QJsonDocument::Compact);
+        record.filterOffset = static_cast<quint32>(blob.size());
+        record.filterSize = static_cast<quint32>(filter.size());
+        blob.append(filter);
+
+        connectionIds.insert(connection, static_cast<quint32>(connections.size()));
+        connections.append(record);
+    }
+
+    buildAdjacency(scheme->connectionsByOutput, connectionIds, strings, outputAdjacency, adjacencyList);
+    buildAdjacency(scheme->connectionsByInput, connectionIds, strings, inputAdjacency, adjacencyList);
+
+    Header header;
+    memset(&header, 0, sizeof(Header));
+    memcpy(header.magic, Magic, sizeof(Magic));
+    header.version = Version;
+    header.sourceMtime = sourceInfo.lastModified().toMSecsSinceEpoch();
+    header.sourceSize = sourceInfo.size();
+    memcpy(header.sourceHash, hash.constData(), sizeof(header.sourceHash));
+    header.description = scheme->m_description.isEmpty() ? NoString : strings.intern(scheme->m_description);
+
+    QByteArray out(sizeof(Header), '\0');
+
+    header.stringCount = static_cast<quint32>(strings.records().size());
+    header.stringOffset = static_cast<quint32>(out.size());
+    appendRecords(out, strings.records());
+
+    header.stringDataOffset = static_cast<quint32>(out.size());
+    out.append(reinterpret_cast<const char*>(strings.data().constData()), strings.data().size() * static_cast<int>(sizeof(QChar)));
+    out.append(QByteArray(static_cast<int>(align8(out.size()) - out.size()), '\0'));
+
+    header.componentCount = static_cast<quint32>(components.size());
+    header.componentOffset = static_cast<quint32>(out.size());
+    appendRecords(out, components);
+
+    header.portCount = static_cast<quint32>(ports.size());
+    header.portOffset = static_cast<quint32>(out.size());
+    appendRecords(out, ports);
+
+    header.connectionCount = static_cast<quint32>(connections.size());
+    header.connectionOffset = static_cast<quint32>(out.size());
+    appendRecords(out, connections);
+
+    header.outputAdjacencyCount = static_cast<quint32>(outputAdjacency.size());
+    header.outputAdjacencyOffset = static_cast<quint32>(out.size());
+    appendRecords(out, outputAdjacency);
+
+    header.inputAdjacencyCount = static_cast<quint32>(inputAdjacency.size());
+    header.inputAdjacencyOffset = static_cast<quint32>(out.size());
+    appendRecords(out, inputAdjacency);
+
+    header.adjacencyListCount = static_cast<quint32>(adjacencyList.size());
+    header.adjacencyListOffset = static_cast<quint32>(out.size());
+    appendRecords(out, adjacencyList);
+
+    header.blobOffset = static_cast<quint32>(out.size());
+    header.blobSize = static_cast<quint32>(blob.size());
+    out.append(blob);
+
+    memcpy(out.data(), &header, sizeof(Header));
+
+    QFile file(cachePath(schemePath));
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        GlobalConsole::writeLine("Cannot write scheme cache into " + file.fileName());
+        return false;
+    }
+    return file.write(out) == out.size();
+}
+
+bool SchemeCache::load(const QString &schemePath, Scheme *scheme)
+{
+    QFileInfo sourceInfo(schemePath);
+    QFile file(cachePath(schemePath));
+    if (!sourceInfo.exists() || !file.exists())
+        return false;
+
+    if (!file.open(QIODevice::ReadOnly) || file.size() < static_cast<qint64>(sizeof(Header)))
+        return false;
+
+    const uchar *base = file.map(0, file.size());
+    if (!base)
+        return false;
+
+    const quint64 size = static_cast<quint64>(file.size());
+    const Header *header = reinterpret_cast<const Header*>(base);
+
+    if (memcmp(header->magic, Magic, sizeof(Magic)) != 0 || header->version != Version)
+        return false;
+    if (header->sourceMtime != sourceInfo.lastModified().toMSecsSinceEpoch() || header->sourceSize != sourceInfo.size())
+        return false;
+
+    QFile source(schemePath);
+    if (!source.open(QIODevice::ReadOnly))
+        return false;
+    if (sourceHash(source.readAll()) != QByteArray(header->sourceHash, sizeof(header->sourceHash)))
+        return false;
+
+    auto fits = [size](quint32 offset, quint32 count, size_t recordSize)
+    {
+        return static_cast<quint64>(offset) + static_cast<quint64>(count) * recordSize <= size;
+    };
+
+    if (!fits(header->stringOffset, header->stringCount, sizeof(StringRecord)) ||
+        !fits(header->componentOffset, header->componentCount, sizeof(ComponentRecord)) ||
+        !fits(header->portOffset, header->portCount, sizeof(PortRecord)) ||
+        !fits(header->connectionOffset, header->connectionCount, sizeof(ConnectionRecord)) ||
+        !fits(header->outputAdjacencyOffset, header->outputAdjacencyCount, sizeof(AdjacencyRecord)) ||
+        !fits(header->inputAdjacencyOffset, header->inputAdjacencyCount, sizeof(AdjacencyRecord)) ||
+        !fits(header->adjacencyListOffset, header->adjacencyListCount, sizeof(quint32)) ||
+        !fits(header->blobOffset, header->blobSize, 1))
+        return false;
+
+    // string data runs up to the component records
+    if (header->stringDataOffset > header->componentOffset || !fits(header->stringDataOffset, 0, 1))
+        return false;
+
+    const StringRecord *stringRecords = reinterpret_cast<const StringRecord*>(base + header->stringOffset);
+    const QChar *stringData = reinterpret_cast<const QChar*>(base + header->stringDataOffset);
+    const ComponentRecord *componentRecords = reinterpret_cast<const ComponentRecord*>(base + header->componentOffset);
+    const PortRecord *portRecords = reinterpret_cast<const PortRecord*>(base + header->portOffset);
+    const ConnectionRecord *connectionRecords = reinterpret_cast<const ConnectionRecord*>(base + header->connectionOffset);
+    const AdjacencyRecord *outputAdjacency = reinterpret_cast<const AdjacencyRecord*>(base + header->outputAdjacencyOffset);
+    const AdjacencyRecord *inputAdjacency = reinterpret_cast<const AdjacencyRecord*>(base + header->inputAdjacencyOffset);
+    const quint32 *adjacencyList = reinterpret_cast<const quint32*>(base + header->adjacencyListOffset);
+    const char *blob = reinterpret_cast<const char*>(base + header->blobOffset);
+
+    // every string is materialized once, equal names share the same QString data afterwards
+    QVector<QString> strings(static_cast<int>(header->stringCount));
+    const quint64 stringDataSize = (header->componentOffset - header->stringDataOffset) / sizeof(QChar);
+    for (quint32 i = 0; i < header->stringCount; i++)
+    {
+        const StringRecord &record = stringRecords[i];
+        if (static_cast<quint64>(record.offset) + record.length > stringDataSize)
+            return false;
+        strings[static_cast<int>(i)] = QString(stringData + record.offset, static_cast<int>(record.length));
+    }
+
+    auto valid = [&strings](quint32 idx) { return idx < static_cast<quint32>(strings.size()); };
+
+    // validate everything before touching the scheme
+    for (quint32 i = 0; i < header->componentCount; i++)
+    {
+        const ComponentRecord &r = componentRecords[i];
+        if (!valid(r.type) || !valid(r.name) || !valid(r.module) ||
+            static_cast<quint64>(r.settingsOffset) + r.settingsSize > header->blobSize ||
+            static_cast<quint64>(r.firstInput) + r.inputCount > header->portCount ||
+            static_cast<quint64>(r.firstOutput) + r.outputCount > header->portCount)
+            return false;
+    }
+    for (quint32 i = 0; i < header->portCount; i++)
+        if (!valid(portRecords[i].name) || !valid(portRecords[i].type))
+            return false;
+    for (quint32 i = 0; i < header->connectionCount; i++)
+    {
+        const ConnectionRecord &r = connectionRecords[i];
+        if (!valid(r.outputComponentName) || !valid(r.outputComponentType) || !valid(r.outputName) || !valid(r.outputType) ||
+            !valid(r.inputComponentName) || !valid(r.inputComponentType) || !valid(r.inputName) || !valid(r.inputType) ||
+            !valid(r.key) || static_cast<quint64>(r.filterOffset) + r.filterSize > header->blobSize)
+            return false;
+    }
+    for (quint32 i = 0; i < header->adjacencyListCount; i++)
+        if (adjacencyList[i] >= header->connectionCount)
+            return false;
+    auto validAdjacency = [&](const AdjacencyRecord *records, quint32 count)
+    {
+        for (quint32 i = 0; i < count; i++)
+            if (!valid(records[i].key) || static_cast<quint64>(records[i].first) + records[i].count > header->adjacencyListCount)
+                return false;
+        return true;
+    };
+    if (!validAdjacency(outputAdjacency, header->outputAdjacencyCount) || !validAdjacency(inputAdjacency, header->inputAdjacencyCount))
+        return false;
+    if (header->description != NoString && !valid(header->description))
+        return false;
+
+    for (quint32 i = 0; i < header->componentCount; i++)
+    {
+        const ComponentRecord &r = componentRecords[i];
+
+        auto component = new ComponentInfo();
+        component->type = strings[static_cast<int>(r.type)];
+        component->name = strings[static_cast<int>(r.name)];
+        component->parentModule = strings[static_cast<int>(r.module)];
+        component->enabled = r.enabled;
+        component->visualX = r.x;
+        component->visualY = r.y;
+        component->settings = QJsonDocument::fromJson(QByteArray::fromRawData(blob + r.settingsOffset, static_cast<int>(r.settingsSize))).object();
+
+        for (quint32 p = r.firstInput; p < r.firstInput + r.inputCount; p++)
+            component->inputsWithType.insert(strings[static_cast<int>(portRecords[p].name)], strings[static_cast<int>(portRecords[p].type)]);
+        for (quint32 p = r.firstOutput; p < r.firstOutput + r.outputCount; p++)
+            component->outputsWithType.insert(strings[static_cast<int>(portRecords[p].name)], strings[static_cast<int>(portRecords[p].type)]);
+
+        scheme->insertComponent(component);
+    }
+
+    QVector<ComponentConnection*> connections(static_cast<int>(header->connectionCount));
+    scheme->connections.reserve(static_cast<int>(header->connectionCount));
+    for (quint32 i = 0; i < header->connectionCount; i++)
+    {
+        const ConnectionRecord &r = connectionRecords[i];
+        auto connection = new ComponentConnection(strings[static_cast<int>(r.outputComponentName)],
+                                                  strings[static_cast<int>(r.outputComponentType)],
+                                                  strings[static_cast<int>(r.outputName)],
+                                                  strings[static_cast<int>(r.outputType)],
+                                                  strings[static_cast<int>(r.inputComponentName)],
+                                                  strings[static_cast<int>(r.inputComponentType)],
+                                                  strings[static_cast<int>(r.inputName)],
+                                                  strings[static_cast<int>(r.inputType)],
+                                                  r.RMIP);
+        connection->isEnabled = r.enabled;
+        connection->deltaMode = r.flags & ConnectionDelta;
+        if (r.filterSize)
+            connection->filter = LinkFilter::Settings::fromJson(QJsonDocument::fromJson(QByteArray::fromRawData(blob + r.filterOffset, static_cast<int>(r.filterSize))).object());
+
+        connections[static_cast<int>(i)] = connection;
+        // channel indexes are filled from the prebuilt adjacency below
+        scheme->insertConnection(connection, false);
+    }
+
+    auto fillIndex = [&](const AdjacencyRecord *records, quint32 count, ConnectionIndex &index)
+    {
+        index.reserve(static_cast<int>(count));
+        for (quint32 i = 0; i < count; i++)
+        {
+            QList<ComponentConnection*> &bucket = index[strings[static_cast<int>(records[i].key)]];
+            bucket.reserve(static_cast<int>(records[i].count));
+            for (quint32 c = records[i].first; c < records[i].first + records[i].count; c++)
+                bucket.append(connections[static_cast<int>(adjacencyList[c])]);
+        }
+    };
+    fillIndex(outputAdjacency, header->outputAdjacencyCount, scheme->connectionsByOutput);
+    fillIndex(inputAdjacency, header->inputAdjacencyCount, scheme->connectionsByInput);
+
+    scheme->m_description = header->description == NoString ? "" : strings[static_cast<int>(header->description)];
+
+    return true;
+}
@@ -0,0 +1,31 @@
+#ifndef SCHEMECACHE_H
+#define SCHEMECACHE_H
+
+#include <QString>
+#include "xoCore_global.h"
+
+class Scheme;
+
+//! Compiled binary form of a scheme file.
+//! The cache is written next to the source as "<name>.scheme.cache" and contains
+//! an interned string table, fixed-size component/connection records and prebuilt
+//! adjacency indexes. It is memory-mapped on load and rejected when the source
+//! file's mtime, size or hash does not match the one it was compiled from.
+class XOCORESHARED_EXPORT SchemeCache
+{
+public:
+    static const QString FileExtensionCacheDot;
+
+    static QString cachePath(const QString &schemePath);
+
+    //! fill the (cleared) scheme from the compiled cache, returns false if the cache is missing or stale
+    static bool load(const QString &schemePath, Scheme *scheme);
+    //! compile the scheme into the cache file for given source path
+    static bool write(const QString &schemePath, const Scheme *scheme);
+    static void remove(const QString &schemePath);
+
+private:
+    SchemeCache() = delete;
+};
+
+#endif // SCHEMECACHE_H
@@ -0,0 +1,207 @@
+#include "SchemeJournal.h"
+#include "Scheme.h"
+
+#include <QDebug>
+#include <QFileInfo>
+#include <QJsonDocument>
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+const QString SchemeJournal::FileExtensionJournalDot = ".journal";
+
+SchemeJournal::SchemeJournal(QObject *parent) : QThread(parent)
+{
+
+}
+
+SchemeJournal::~SchemeJournal()
+{
+    close();
+}
+
+QString SchemeJournal::journalPath(const QString &schemePath)
+{
+    return schemePath + FileExtensionJournalDot;
+}
+
+void SchemeJournal::remove(const QString &schemePath)
+{
+    QFile::remove(journalPath(schemePath));
+}
+
+bool SchemeJournal::open(const QString &schemePath, int existingRecords)
+{
+    close();
+
+    m_schemePath = schemePath;
+    m_path = journalPath(schemePath);
+    m_recordCount = existingRecords;
+    m_appended = dropTornRecord(m_path);
+    m_cut = 0;
+    m_generation++;
+    m_cuts.clear();
+    m_stop = false;
+    m_pending.clear();
+
+    start(QThread::LowPriority);
+    return true;
+}
+
+void SchemeJournal::close()
+{
+    if (!isRunning())
+    {
+        m_path.clear();
+        m_schemePath.clear();
+        return;
+    }
+
+    {
+        QMutexLocker lock(&m_mutex);
+        m_stop = true;
+        m_condition.wakeOne();
+    }
+    wait();
+
+    m_path.clear();
+    m_schemePath.clear();
+    m_recordCount = 0;
+}
+
+void SchemeJournal::append(const QJsonObject &record)
+{
+    if (!isOpen())
+        return;
+
+    QByteArray line = QJsonDocument(record).toJson(QJsonDocument::Compact);
+    line.append('\n');
+
+    QMutexLocker lock(&m_mutex);
+    m_pending.append(line);
+    m_appended += line.size();
+    m_recordCount++;
+    m_condition.wakeOne();
+}
+
+qint64 SchemeJournal::dropTornRecord(const QString &path)
+{
+    QFile file(path);
+    if (!file.exists() || !file.open(QIODevice::ReadWrite))
+        return 0;
+
+    // a crash may leave the last line unfinished, the next record must not be glued to it
+    static const qint64 ChunkSize = 4096;
+    qint64 end = file.size();
+    while (end > 0)
+    {
+        qint64 start = qMax<qint64>(0, end - ChunkSize);
+        file.seek(start);
+        QByteArray chunk = file.read(end - start);
+        int newline = chunk.lastIndexOf('\n');
+        if (newline >= 0)
+        {
+            end = start + newline + 1;
+            break;
+        }
+        end = start;
+    }
+
+    if (end != file.size())
+        file.resize(end);
+    return end;
+}
+
+void SchemeJournal::truncateBefore(qint64 mark, int generation)
+{
+    // a mark of a previous session points into a file that has been replaced or reopened since
+    if (!isOpen() || generation != m_generation || mark <= m_cut)
+        return;
+
+    QMutexLocker lock(&m_mutex);
+    m_cuts << mark - m_cut;
+    m_cut = mark;
+    m_condition.wakeOne();
+}
+
+void SchemeJournal::run()
+{
+    QFile file(m_path);
+    if (!file.open(QIODevice::ReadWrite | QIODevice::Append))
+    {
+        qDebug() << "[SchemeJournal] cannot open" << m_path;
+        return;
+    }
+
+    forever
+    {
+        QByteArray data;
+        QList<qint64> cuts;
+        bool stop = false;
+
+        {
+            QMutexLocker lock(&m_mutex);
+            while (m_pending.isEmpty() && m_cuts.isEmpty() && !m_stop)
+                m_condition.wait(&m_mutex);
+
+            data.swap(m_pending);
+            cuts.swap(m_cuts);
+            stop = m_stop;
+        }
+
+        if (!data.isEmpty())
+            file.write(data);
+
+        // records behind a cut may already be queued, they are written first and kept as the tail
+        for (qint64 cut : cuts)
+        {
+            file.flush();
+            file.seek(qMin(cut, file.size()));
+            QByteArray tail = file.readAll();
+            file.resize(0);
+            file.write(tail);
+        }
+
+        if (!cuts.isEmpty() || !data.isEmpty())
+        {
+            file.flush();
+#ifdef Q_OS_WIN
+            _commit(file.handle());
+#else
+            fsync(file.handle());
+#endif
+        }
+
+        if (stop)
+            break;
+    }
+}
+
+int SchemeJournal::replay(const QString &schemePath, Scheme *scheme)
+{
+    QFile file(journalPath(schemePath));
+    if (!file.open(QIODevice::ReadOnly))
+        return 0;
+
+    int count = 0;
+    while (!file.atEnd())
+    {
+        QByteArray line = file.readLine().trimmed();
+        if (line.isEmpty())
+            continue;
+
+        // the last line may be torn by a crash, everything before it is valid
+        QJsonParseError error;
+        QJsonObject record = QJsonDocument::fromJson(line, &error).object();
+        if (error.error != QJsonParseError::NoError)
+            break;
+
+        if (scheme->applyJournalRecord(record))
+            count++;
+    }
+
+    return count;
+}
@@ -0,0 +1,72 @@
+#ifndef SCHEMEJOURNAL_H
+#define SCHEMEJOURNAL_H
+
+#include <QFile>
+#include <QMutex>
+#include <QThread>
+#include <QJsonObject>
+#include <QWaitCondition>
+#include "xoCore_global.h"
+
+class Scheme;
+
+//! Append-only edit log of a scheme, stored next to it as "<name>.scheme.journal".
+//! Every edit is one compact JSON line; lines are written and fsync'd by the journal's
+//! own thread, so recording an edit never touches the disk on the caller's thread.
+//! Loading a scheme replays its journal over the snapshot; once a snapshot is on disk the
+//! records it contains are cut off the head of the journal.
+class XOCORESHARED_EXPORT SchemeJournal : public QThread
+{
+    Q_OBJECT
+public:
+    static const QString FileExtensionJournalDot;
+
+    explicit SchemeJournal(QObject *parent = nullptr);
+    ~SchemeJournal() override;
+
+    static QString journalPath(const QString &schemePath);
+    static void remove(const QString &schemePath);
+
+    //! apply journal records of the scheme file to already loaded snapshot, returns the number of records applied
+    static int replay(const QString &schemePath, Scheme *scheme);
+
+    bool open(const QString &schemePath, int existingRecords = 0);
+    void close();
+    bool isOpen() const { return !m_path.isEmpty(); }
+    QString schemePath() const { return m_schemePath; }
+
+    void append(const QJsonObject &record);
+
+    //! position after the last appended record, taken when a snapshot is serialized
+    qint64 mark() const { return m_appended; }
+    //! marks are positions in one session of the journal, every open starts a new one
+    int generation() const { return m_generation; }
+    //! drop records up to the mark once the snapshot taken at that mark is written,
+    //! marks of an earlier generation are ignored
+    void truncateBefore(qint64 mark, int generation);
+    void resetRecordCount() { m_recordCount = 0; }
+
+    int recordCount() const { return m_recordCount; }
+
+protected:
+    void run() override;
+
+private:
+    //! cut an unfinished last line off the file, returns the size left
+    static qint64 dropTornRecord(const QString &path);
+
+    QString m_schemePath;
+    QString m_path;
+    int m_recordCount = 0;
+    qint64 m_appended = 0; //!< journal bytes ever appended, including the file content at open
+    qint64 m_cut = 0;      //!< journal bytes ever cut off the head
+    int m_generation = 0;  //!< sessions opened so far
+
+    QMutex m_mutex;
+    QWaitCondition m_condition;
+    QByteArray m_pending;
+    QList<qint64> m_cuts;  //!< sizes to cut, each relative to the file after the previous cut
+    bool m_stop = false;
+};
+
+#endif // SCHEMEJOURNAL_H
@@ -0,0 +1,312 @@
+#include "ScriptBridge.h"
+
+#include <QThread>
+#include <QMetaMethod>
+#include <QMetaProperty>
+
+//! Receives signals of any signature: every connection targets its own method index past
+//! the methods of QObject, which lands in qt_metacall (the way QSignalSpy does it).
+//! The arguments are copied into variants and handed over to the engine's thread.
+class ScriptSignalRelay : public QObject
+{
+public:
+    explicit ScriptSignalRelay(ScriptBridge *bridge) : m_bridge(bridge) {}
+
+    int add(QObject *sender, const QMetaMethod &signal)
+    {
+        QMutexLocker lock(&m_mutex);
+        int id = ++m_lastId;
+        // directly in the sender's thread, the bridge signal is what crosses threads
+        QMetaObject::Connection handle = QMetaObject::connect(sender, signal.methodIndex(), this,
+                                                              QObject::staticMetaObject.methodCount() + id,
+                                                              Qt::DirectConnection);
+        if (!handle)
+            return 0;
+        m_connections.insert(id, Connection{sender, signal, handle});
+        return id;
+    }
+
+    void remove(int id)
+    {
+        QMutexLocker lock(&m_mutex);
+        auto it = m_connections.find(id);
+        if (it == m_connections.end())
+            return;
+        QObject::disconnect(it->handle);
+        m_connections.erase(it);
+    }
+
+    //! Qt drops the connections of a destroyed sender, only the records are left
+    void removeSender(QObject *sender)
+    {
+        QMutexLocker lock(&m_mutex);
+        for (auto it = m_connections.begin(); it != m_connections.end();)
+        {
+            if (it->sender == sender)
+                it = m_connections.erase(it);
+            else
+                ++it;
+        }
+    }
+
+    int qt_metacall(QMetaObject::Call call, int id, void **argv) override
+    {
+        id = QObject::qt_metacall(call, id, argv);
+        if (id < 0 || call != QMetaObject::InvokeMetaMethod)
+            return id;
+
+        QVariantList args;
+        {
+            QMutexLocker lock(&m_mutex);
+            auto it = m_connections.constFind(id);
+            if (it == m_connections.constEnd())
+                return -1;
+            for (int i = 0; i < it->signal.parameterCount(); i++)
+            {
+                int type = it->signal.parameterType(i);
+                args << (type == QMetaType::QVariant ? *static_cast<QVariant*>(argv[i + 1]) :
+                                                       QVariant(type, argv[i + 1]));
+            }
+        }
+        emit m_bridge->signalEmitted(id, args);
+        return -1;
+    }
+
+private:
+    struct Connection
+    {
+        QObject *sender;
+        QMetaMethod signal;
+        QMetaObject::Connection handle;
+    };
+
+    ScriptBridge *m_bridge;
+    QMutex m_mutex;
+    QHash<int, Connection> m_connections;
+    int m_lastId = 0;
+};
+
+ScriptBridge::ScriptBridge(QObject *parent) : QObject(parent),
+    m_relay(new ScriptSignalRelay(this))
+{
+
+}
+
+ScriptBridge::~ScriptBridge()
+{
+    delete m_relay;
+}
+
+void ScriptBridge::track(QObject *object)
+{
+    if (!object || m_objects.contains(object))
+        return;
+
+    m_objects << object;
+    connect(object, &QObject::destroyed, this, [=]()
+    {
+        m_objects.remove(object);
+        m_relay->removeSender(object);
+    });
+}
+
+QVariant ScriptBridge::callFromScript(QObject *target, const QString &method, const QVariantList &args)
+{
+    if (QThread::currentThread() == thread())
+        return call(target, method, args);
+
+    QVariant result;
+    QMetaObject::invokeMethod(this, "call", Qt::BlockingQueuedConnection, Q_RETURN_ARG(QVariant, result),
+                              Q_ARG(QObject*, target), Q_ARG(QString, method), Q_ARG(QVariantList, args));
+    return result;
+}
+
+QVariant ScriptBridge::readFromScript(QObject *target, const QString &property)
+{
+    if (QThread::currentThread() == thread())
+        return read(target, property);
+
+    QVariant result;
+    QMetaObject::invokeMethod(this, "read", Qt::BlockingQueuedConnection, Q_RETURN_ARG(QVariant, result),
+                              Q_ARG(QObject*, target), Q_ARG(QString, property));
+    return result;
+}
+
+bool ScriptBridge::writeFromScript(QObject *target, const QString &property, const QVariant &value)
+{
+    if (QThread::currentThread() == thread())
+        return write(target, property, value);
+
+    bool result = false;
+    QMetaObject::invokeMethod(this, "write", Qt::BlockingQueuedConnection, Q_RETURN_ARG(bool, result),
+                              Q_ARG(QObject*, target), Q_ARG(QString, property), Q_ARG(QVariant, value));
+    return result;
+}
+
+QVariantMap ScriptBridge::describeFromScript(QObject *target)
+{
+    if (QThread::currentThread() == thread())
+        return describe(target);
+
+    QVariantMap result;
+    QMetaObject::invokeMethod(this, "describe", Qt::BlockingQueuedConnection, Q_RETURN_ARG(QVariantMap, result),
+                              Q_ARG(QObject*, target));
+    return result;
+}
+
+bool ScriptBridge::hasPropertyFromScript(QObject *target, const QString &property)
+{
+    if (QThread::currentThread() == thread())
+        return hasProperty(target, property);
+
+    bool result = false;
+    QMetaObject::invokeMethod(this, "hasProperty", Qt::BlockingQueuedConnection, Q_RETURN_ARG(bool, result),
+                              Q_ARG(QObject*, target), Q_ARG(QString, property));
+    return result;
+}
+
+int ScriptBridge::connectFromScript(QObject *target, const QString &signal)
+{
+    if (QThread::currentThread() == thread())
+        return connectSignal(target, signal);
+
+    int result = 0;
+    QMetaObject::invokeMethod(this, "connectSignal", Qt::BlockingQueuedConnection, Q_RETURN_ARG(int, result),
+                              Q_ARG(QObject*, target), Q_ARG(QString, signal));
+    return result;
+}
+
+void ScriptBridge::disconnectFromScript(int connection)
+{
+    // the relay is guarded by its own lock
+    m_relay->remove(connection);
+}
+
+QVariant ScriptBridge::call(QObject *target, QString method, QVariantList args)
+{
+    if (!isAlive(target) || args.size() > 10)
+        return QVariant();
+
+    const QMetaObject *mo = target->metaObject();
+    for (int i = 0; i < mo->methodCount(); i++)
+    {
+        QMetaMethod m = mo->method(i);
+        if (m.name() != method.toLatin1() || m.parameterCount() != args.size())
+            continue;
+
+        // convert arguments to the parameter types, QVariant parameters take them as is
+        QVariantList values = args;
+        QGenericArgument arguments[10];
+        bool ok = true;
+        for (int p = 0; p < values.size(); p++)
+        {
+            int type = m.parameterType(p);
+            if (type != QMetaType::QVariant && !values[p].convert(type))
+            {
+                ok = false;
+                break;
+            }
+            arguments[p] = type == QMetaType::QVariant ?
+                        QGenericArgument("QVariant", &values[p]) :
+                        QGenericArgument(m.parameterTypes()[p].constData(), values[p].constData());
+        }
+        if (!ok)
+            continue;
+
+        QVariant result;
+        QGenericReturnArgument returnArgument;
+        if (m.returnType() == QMetaType::QVariant)
+            returnArgument = QGenericReturnArgument("QVariant", &result);
+        else if (m.returnType() != QMetaType::Void)
+        {
+            result = QVariant(m.returnType(), nullptr);
+            returnArgument = QGenericReturnArgument(m.typeName(), result.data());
+        }
+
+        m.invoke(target, Qt::DirectConnection, returnArgument,
+                 arguments[0], arguments[1], arguments[2], arguments[3], arguments[4],
+                 arguments[5], arguments[6], arguments[7], arguments[8], arguments[9]);
+
+        // returned objects are wrapped by the script engine, so they become accessible too
+        if (result.canConvert<QObject*>())
+            track(result.value<QObject*>());
+        return result;
+    }
+    return QVariant();
+}
+
+QVariant ScriptBridge::read(QObject *target, QString property)
+{
+    if (!isAlive(target))
+        return QVariant();
+
+    QVariant result = target->property(property.toUtf8());
+    if (result.canConvert<QObject*>())
+        track(result.value<QObject*>());
+    return result;
+}
+
+bool ScriptBridge::write(QObject *target, QString property, QVariant value)
+{
+    if (!isAlive(target))
+        return false;
+    return target->setProperty(property.toUtf8(), value);
+}
+
+QVariantMap ScriptBridge::describe(QObject *target)
+{
+    QVariantMap result;
+    if (!isAlive(target))
+        return result;
+
+    QStringList methods, signalNames, properties;
+    const QMetaObject *mo = target->metaObject();
+    for (int i = 0; i < mo->methodCount(); i++)
+    {
+        QMetaMethod method = mo->method(i);
+        if (method.access() != QMetaMethod::Public)
+            continue;
+
+        // overloads are resolved when called, by the arguments
+        QString name = QString::fromLatin1(method.name());
+        QStringList &names = method.methodType() == QMetaMethod::Signal ? signalNames : methods;
+        if (method.methodType() != QMetaMethod::Constructor && !names.contains(name))
+            names << name;
+    }
+    for (int i = 0; i < mo->propertyCount(); i++)
+        properties << QString::fromLatin1(mo->property(i).name());
+
+    result["methods"] = methods;
+    result["signals"] = signalNames;
+    result["properties"] = properties;
+    return result;
+}
+
+bool ScriptBridge::hasProperty(QObject *target, QString property)
+{
+    if (!isAlive(target))
+        return false;
+    QByteArray name = property.toUtf8();
+    return target->metaObject()->indexOfProperty(name) >= 0 || target->dynamicPropertyNames().contains(name);
+}
+
+int ScriptBridge::connectSignal(QObject *target, QString signal)
+{
+    if (!isAlive(target))
+        return 0;
+
+    const QMetaObject *mo = target->metaObject();
+    for (int i = 0; i < mo->methodCount(); i++)
+    {
+        QMetaMethod method = mo->method(i);
+        if (method.methodType() == QMetaMethod::Signal && method.access() == QMetaMethod::Public &&
+            method.name() == signal.toLatin1())
+            return m_relay->add(target, method);
+    }
+    return 0;
+}
+
+void ScriptBridge::disconnectSignal(int connection)
+{
+    m_relay->remove(connection);
+}
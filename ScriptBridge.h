@@ -0,0 +1,59 @@
+#ifndef SCRIPTBRIDGE_H
+#define SCRIPTBRIDGE_H
+
+#include <QSet>
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QVariant>
+#include "xoCore_global.h"
+
+class ScriptSignalRelay;
+
+//! Lives in the main thread and performs calls of the script thread on main thread objects.
+//! The script engine doesn't touch components directly: every method call, property
+//! access and meta-object lookup is marshalled here with a blocking queued call.
+//! Signals connected from scripts come back to the engine as signalEmitted.
+class XOCORESHARED_EXPORT ScriptBridge : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ScriptBridge(QObject *parent = nullptr);
+    ~ScriptBridge() override;
+
+    //! objects that may be accessed from scripts, they are forgotten when destroyed;
+    //! to be called in the bridge's thread before the object is passed to the engine
+    void track(QObject *object);
+
+    //! thread-safe: block the calling (script) thread until the main thread has done the job
+    QVariant callFromScript(QObject *target, const QString &method, const QVariantList &args);
+    QVariant readFromScript(QObject *target, const QString &property);
+    bool writeFromScript(QObject *target, const QString &property, const QVariant &value);
+    //! names of public methods, signals and properties: {"methods": [], "signals": [], "properties": []}
+    QVariantMap describeFromScript(QObject *target);
+    //! static or dynamic property, dynamic ones may appear any time
+    bool hasPropertyFromScript(QObject *target, const QString &property);
+    //! returns the connection id (0 if there is no such signal), emissions arrive as signalEmitted
+    int connectFromScript(QObject *target, const QString &signal);
+    void disconnectFromScript(int connection);
+
+    Q_INVOKABLE QVariant call(QObject *target, QString method, QVariantList args);
+    Q_INVOKABLE QVariant read(QObject *target, QString property);
+    Q_INVOKABLE bool write(QObject *target, QString property, QVariant value);
+    Q_INVOKABLE QVariantMap describe(QObject *target);
+    Q_INVOKABLE bool hasProperty(QObject *target, QString property);
+    Q_INVOKABLE int connectSignal(QObject *target, QString signal);
+    Q_INVOKABLE void disconnectSignal(int connection);
+
+signals:
+    //! emitted in the thread of the sender, to be received queued
+    void signalEmitted(int connection, QVariantList args);
+
+private:
+    QSet<QObject*> m_objects;
+    ScriptSignalRelay *m_relay;
+
+    bool isAlive(QObject *target) const { return target && m_objects.contains(target); }
+};
+
+#endif // SCRIPTBRIDGE_H
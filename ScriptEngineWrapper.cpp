@@ -1,26 +1,204 @@
 #include "ScriptEngineWrapper.h"
 
-ScriptEngineWrapper::ScriptEngineWrapper(QObject *parent) : QScriptEngine(parent)
+#include <QFile>
+#include <QDebug>
+#include <QFileInfo>
+#include <QFutureInterface>
+#include <QtScript/QScriptClass>
+#include <QtScript/QScriptString>
+#include <QtScript/QScriptValueIterator>
+
+//! Class of wrapped objects: members are resolved when accessed, so dynamic properties set
+//! after the object was wrapped are visible too. Method, signal and property names are read
+//! through the bridge when the object is wrapped.
+class ScriptObjectClass : public QScriptClass
+{
+public:
+    struct Members
+    {
+        QStringList methods;
+        QStringList signalNames;
+        QStringList properties;
+    };
+    QHash<QObject*, Members> members;
+
+    explicit ScriptObjectClass(ScriptEngineWrapper *engine) : QScriptClass(engine), m_engine(engine) {}
+
+    QString name() const override { return "QObject"; }
+
+    QueryFlags queryProperty(const QScriptValue &object, const QScriptString &name, QueryFlags flags, uint *id) override
+    {
+        Q_UNUSED(id)
+        QObject *obj = target(object);
+        QString n = name.toString();
+        auto it = members.constFind(obj);
+        if (it != members.constEnd() && (it->methods.contains(n) || it->signalNames.contains(n)))
+            return flags & HandlesReadAccess;
+        if ((it != members.constEnd() && it->properties.contains(n)) || m_engine->m_bridge->hasPropertyFromScript(obj, n))
+            return flags;
+        return QueryFlags(); // an ordinary script property
+    }
+
+    QScriptValue property(const QScriptValue &object, const QScriptString &name, uint id) override
+    {
+        Q_UNUSED(id)
+        QObject *obj = target(object);
+        QString n = name.toString();
+        const Members m = members.value(obj);
+        if (m.methods.contains(n))
+            return m_engine->memberFunction(ScriptEngineWrapper::callMethod, object.data(), n);
+        if (m.signalNames.contains(n))
+        {
+            QScriptValue signal = m_engine->newObject();
+            signal.setProperty("connect", m_engine->memberFunction(ScriptEngineWrapper::connectSignal, object.data(), n));
+            signal.setProperty("disconnect", m_engine->memberFunction(ScriptEngineWrapper::disconnectSignal, object.data(), n));
+            return signal;
+        }
+        return m_engine->fromResult(m_engine->m_bridge->readFromScript(obj, n));
+    }
+
+    void setProperty(QScriptValue &object, const QScriptString &name, uint id, const QScriptValue &value) override
+    {
+        Q_UNUSED(id)
+        m_engine->m_bridge->writeFromScript(target(object), name.toString(), m_engine->toArgument(value));
+    }
+
+private:
+    ScriptEngineWrapper *m_engine;
+
+    static QObject *target(const QScriptValue &object) { return object.data().toVariant().value<QObject*>(); }
+};
+
+ScriptEngineWrapper::ScriptEngineWrapper(ScriptBridge *bridge, QObject *parent) : QScriptEngine(parent),
+    m_bridge(bridge),
+    m_objectClass(new ScriptObjectClass(this))
 {
+    connect(m_bridge, &ScriptBridge::signalEmitted, this, &ScriptEngineWrapper::deliverSignal, Qt::QueuedConnection);
 
+    // the watchdog can fire only while the engine processes events during evaluation
+    setProcessEventsInterval(50);
+
+    m_watchdog = new QTimer(this);
+    m_watchdog->setSingleShot(true);
+    connect(m_watchdog, &QTimer::timeout, this, [=]()
+    {
+        if (isEvaluating())
+            abortEvaluation(currentContext()->throwError(QString("script exceeded %1 ms").arg(m_timeBudgetMs)));
+    });
+}
+
+ScriptEngineWrapper::~ScriptEngineWrapper()
+{
+    // objects of the class keep a plain pointer to it but never call it when they are collected
+    delete m_objectClass;
+}
+
+QFuture<QString> ScriptEngineWrapper::evaluateAsync(const QString &text)
+{
+    QFutureInterface<QString> result;
+    result.reportStarted();
+    QTimer::singleShot(0, this, [=]() mutable
+    {
+        result.reportResult(evaluateText(text));
+        result.reportFinished();
+    });
+    return result.future();
+}
+
+QFuture<QString> ScriptEngineWrapper::evaluateFileAsync(const QString &path)
+{
+    QFutureInterface<QString> result;
+    result.reportStarted();
+    QTimer::singleShot(0, this, [=]() mutable
+    {
+        result.reportResult(evaluateFile(path));
+        result.reportFinished();
+    });
+    return result.future();
+}
+
+QString ScriptEngineWrapper::evaluateText(const QString &text)
+{
+    return run(QScriptProgram(text));
+}
+
+QString ScriptEngineWrapper::evaluateFile(const QString &path)
+{
+    QScriptProgram compiled = program(path);
+    if (compiled.isNull())
+        return "cannot read " + path;
+    return run(compiled);
+}
+
+QScriptProgram ScriptEngineWrapper::program(const QString &path)
+{
+    QFileInfo info(path);
+    auto it = m_programs.constFind(path);
+    if (it != m_programs.constEnd() && it->modified == info.lastModified() && it->size == info.size())
+        return it->program;
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return QScriptProgram();
+
+    CachedProgram cached;
+    cached.modified = info.lastModified();
+    cached.size = info.size();
+    cached.program = QScriptProgram(QString::fromUtf8(file.readAll()), info.fileName());
+    m_programs[path] = cached;
+    return cached.program;
+}
+
+QString ScriptEngineWrapper::run(const QScriptProgram &program)
+{
+    if (m_timeBudgetMs > 0)
+        m_watchdog->start(m_timeBudgetMs);
+
+    QString result = evaluate(program).toString();
+
+    m_watchdog->stop();
+    return result;
 }
 
 void ScriptEngineWrapper::addVariable(QObject *variable)
 {
-    QString name = variable->property("name").toString();
+    QString name = m_bridge->readFromScript(variable, "name").toString();
     if (name.isEmpty())
         return;
 
     if (globalObject().property(name).isValid()) // if variable exists
-        deleteVariable(variable);
+        globalObject().setProperty(name, QScriptValue());
 
-    globalObject().setProperty(name, newQObject(variable));
+    globalObject().setProperty(name, wrap(variable));
 }
 
 void ScriptEngineWrapper::deleteVariable(QObject *variable)
 {
-    QString name = variable->property("name").toString();
-    globalObject().setProperty(name, QScriptValue());
+    for (auto it = m_handlers.begin(); it != m_handlers.end();)
+    {
+        if (it->target == variable)
+        {
+            m_bridge->disconnectFromScript(it.key());
+            it = m_handlers.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+    m_objectClass->members.remove(variable);
+
+    // the object may be gone already, find it by identity
+    QScriptValueIterator it(globalObject());
+    while (it.hasNext())
+    {
+        it.next();
+        if (it.value().data().toVariant().value<QObject*>() == variable)
+        {
+            globalObject().setProperty(it.name(), QScriptValue());
+            return;
+        }
+    }
 }
 
 void ScriptEngineWrapper::renameVariable(QString oldName, QString newName)
@@ -28,3 +206,128 @@ void ScriptEngineWrapper::renameVariable(QString oldName, QString newName)
     globalObject().setProperty(newName, globalObject().property(oldName));
     globalObject().setProperty(oldName, QScriptValue());
 }
+
+QScriptValue ScriptEngineWrapper::wrap(QObject *object)
+{
+    // the meta-object is read by the bridge, in the object's thread and only if the object is alive
+    QVariantMap description = m_bridge->describeFromScript(object);
+    ScriptObjectClass::Members &members = m_objectClass->members[object];
+    members.methods = description.value("methods").toStringList();
+    members.signalNames = description.value("signals").toStringList();
+    members.properties = description.value("properties").toStringList();
+
+    return newObject(m_objectClass, newVariant(QVariant::fromValue<QObject*>(object)));
+}
+
+QVariant ScriptEngineWrapper::toArgument(const QScriptValue &value) const
+{
+    if (value.scriptClass() == m_objectClass)
+        return value.data().toVariant();
+    return value.toVariant();
+}
+
+QScriptValue ScriptEngineWrapper::fromResult(const QVariant &value)
+{
+    if (value.canConvert<QObject*>() && value.value<QObject*>())
+        return wrap(value.value<QObject*>());
+    return toScriptValue(value);
+}
+
+QScriptValue ScriptEngineWrapper::memberFunction(FunctionSignature function, const QScriptValue &target, const QString &name)
+{
+    QScriptValue result = newFunction(function);
+    QScriptValue data = newObject();
+    data.setProperty("target", target);
+    data.setProperty("name", name);
+    result.setData(data);
+    return result;
+}
+
+void ScriptEngineWrapper::deliverSignal(int connection, QVariantList args)
+{
+    auto it = m_handlers.constFind(connection);
+    if (it == m_handlers.constEnd())
+        return; // disconnected while the emission was queued
+
+    // a copy: the handler may disconnect itself
+    SignalHandler handler = *it;
+    QScriptValueList values;
+    for (const QVariant &arg : args)
+        values << fromResult(arg);
+
+    // a handler called between evaluations gets its own time budget
+    bool nested = m_watchdog->isActive();
+    if (!nested && m_timeBudgetMs > 0)
+        m_watchdog->start(m_timeBudgetMs);
+
+    handler.function.call(handler.thisObject, values);
+
+    if (!nested)
+        m_watchdog->stop();
+
+    if (hasUncaughtException())
+    {
+        qWarning() << "[ScriptEngineWrapper]" << handler.signal << "handler:" << uncaughtException().toString();
+        clearExceptions();
+    }
+}
+
+QScriptValue ScriptEngineWrapper::callMethod(QScriptContext *context, QScriptEngine *engine)
+{
+    auto wrapper = static_cast<ScriptEngineWrapper*>(engine);
+    QScriptValue data = context->callee().data();
+    QObject *target = data.property("target").toVariant().value<QObject*>();
+
+    QVariantList args;
+    for (int i = 0; i < context->argumentCount(); i++)
+        args << wrapper->toArgument(context->argument(i));
+
+    QVariant result = wrapper->m_bridge->callFromScript(target, data.property("name").toString(), args);
+    return wrapper->fromResult(result);
+}
+
+QScriptValue ScriptEngineWrapper::connectSignal(QScriptContext *context, QScriptEngine *engine)
+{
+    auto wrapper = static_cast<ScriptEngineWrapper*>(engine);
+    QScriptValue data = context->callee().data();
+    QObject *target = data.property("target").toVariant().value<QObject*>();
+    QString signal = data.property("name").toString();
+
+    // connect(function) or connect(thisObject, function), as with signals of QtScript
+    bool withThis = context->argumentCount() > 1;
+    QScriptValue function = context->argument(withThis ? 1 : 0);
+    if (!function.isFunction())
+        return context->throwError(QScriptContext::TypeError, signal + ".connect: a function is expected");
+
+    int connection = wrapper->m_bridge->connectFromScript(target, signal);
+    if (!connection)
+        return context->throwError(signal + ".connect: the object is gone");
+
+    SignalHandler handler;
+    handler.target = target;
+    handler.signal = signal;
+    handler.thisObject = withThis ? context->argument(0) : QScriptValue();
+    handler.function = function;
+    wrapper->m_handlers.insert(connection, handler);
+    return engine->undefinedValue();
+}
+
+QScriptValue ScriptEngineWrapper::disconnectSignal(QScriptContext *context, QScriptEngine *engine)
+{
+    auto wrapper = static_cast<ScriptEngineWrapper*>(engine);
+    QScriptValue data = context->callee().data();
+    QObject *target = data.property("target").toVariant().value<QObject*>();
+    QString signal = data.property("name").toString();
+    QScriptValue function = context->argument(context->argumentCount() > 1 ? 1 : 0);
+
+    for (auto it = wrapper->m_handlers.begin(); it != wrapper->m_handlers.end(); ++it)
+    {
+        if (it->target == target && it->signal == signal && it->function.strictlyEquals(function))
+        {
+            wrapper->m_bridge->disconnectFromScript(it.key());
+            wrapper->m_handlers.erase(it);
+            return engine->undefinedValue();
+        }
+    }
+    return context->throwError(signal + ".disconnect: the function is not connected");
+}
@@ -1,21 +1,92 @@
 #ifndef SCRIPTENGINEWRAPPER_H
 #define SCRIPTENGINEWRAPPER_H
 
+#include <QHash>
+#include <QTimer>
+#include <QFuture>
+#include <QDateTime>
 #include <QtScript/QScriptEngine>
+#include <QtScript/QScriptProgram>
 
+#include "ScriptBridge.h"
 #include "xoCore_global.h"
 
+class ScriptObjectClass;
+
+//! Script engine running in its own thread.
+//! Objects added as variables are not exposed directly: their slots, invokable methods,
+//! properties (dynamic ones included) and signals are reached through the ScriptBridge
+//! in the thread the objects live in. Signal handlers run in the engine's thread.
+//! Script files are compiled once and reused while the file is unchanged; an evaluation
+//! running longer than the time budget is aborted.
 class XOCORESHARED_EXPORT ScriptEngineWrapper : public QScriptEngine
 {
     Q_OBJECT
 public:
-    explicit ScriptEngineWrapper(QObject *parent = nullptr);
+    static const int DefaultTimeBudgetMs = 10000;
+
+    explicit ScriptEngineWrapper(ScriptBridge *bridge, QObject *parent = nullptr);
+    ~ScriptEngineWrapper() override;
+
+    ScriptBridge *bridge() const { return m_bridge; }
+
+    //! 0 means no limit
+    void setTimeBudget(int ms) { m_timeBudgetMs = ms; }
+    int timeBudget() const { return m_timeBudgetMs; }
+
+    //! thread-safe: queue the evaluation into the engine's thread
+    QFuture<QString> evaluateAsync(const QString &text);
+    QFuture<QString> evaluateFileAsync(const QString &path);
+
+    //! in the engine's thread only
+    QString evaluateText(const QString &text);
+    QString evaluateFile(const QString &path);
 
 public slots:
     void addVariable(QObject * variable);
     void deleteVariable(QObject *variable);
     void renameVariable(QString oldName, QString newName);
 
+private slots:
+    void deliverSignal(int connection, QVariantList args);
+
+private:
+    struct CachedProgram
+    {
+        QDateTime modified;
+        qint64 size = 0;
+        QScriptProgram program;
+    };
+
+    //! a script function connected to a signal, by bridge connection id
+    struct SignalHandler
+    {
+        QObject *target;
+        QString signal;
+        QScriptValue thisObject;
+        QScriptValue function;
+    };
+
+    ScriptBridge *m_bridge;
+    int m_timeBudgetMs = DefaultTimeBudgetMs;
+    QTimer *m_watchdog;
+    QHash<QString, CachedProgram> m_programs;
+    ScriptObjectClass *m_objectClass;
+    QHash<int, SignalHandler> m_handlers;
+
+    QScriptProgram program(const QString &path);
+    QString run(const QScriptProgram &program);
+    QScriptValue wrap(QObject *object);
+    //! wrapped objects are passed back to the bridge as the objects themselves
+    QVariant toArgument(const QScriptValue &value) const;
+    QScriptValue fromResult(const QVariant &value);
+    QScriptValue memberFunction(FunctionSignature function, const QScriptValue &target, const QString &name);
+
+    static QScriptValue callMethod(QScriptContext *context, QScriptEngine *engine);
+    static QScriptValue connectSignal(QScriptContext *context, QScriptEngine *engine);
+    static QScriptValue disconnectSignal(QScriptContext *context, QScriptEngine *engine);
+
+    friend class ScriptObjectClass;
 };
 
 #endif // SCRIPTENGINEWRAPPER_H
@@ -1,4 +1,6 @@
 #include "Server.h"
+#include "Tracer.h"
+#include "Module/InProcessTransport.h"
 
 #include <QtWebSockets/QtWebSockets>
 
@@ -113,7 +115,7 @@ void Server::slotTakeTextData(QWebSocket* in_pConnection, QString in_data)
     if (!module) // in_data contains the name of the module in this case
         addNewComponent(in_pConnection, in_data);
     else
-        qDebug() << module->name() << ">" << in_data;
+        XO_TRACE_INFO(Module, "text", module->name() + " > " + in_data);
 }
 
 void Server::addNewComponent(QWebSocket* in_pSocket, QString in_id)
@@ -129,6 +131,19 @@ void Server::addNewComponent(QWebSocket* in_pSocket, QString in_id)
     emit moduleConnection(proxy);
 }
 
+void Server::addInProcessModule(QString moduleName, QObject *endpoint)
+{
+    auto proxy = new ModuleProxyONB(moduleName);
+    if (!InProcessTransport::connect(endpoint, proxy))
+    {
+        delete proxy;
+        return;
+    }
+
+    XO_TRACE_INFO(Module, "in-process module", moduleName);
+    emit moduleConnection(proxy);
+}
+
 void Server::slotTakeByteData(QWebSocket *in_pConnection, const QByteArray &in_data)
 {
     if (!m_connections.contains(in_pConnection))
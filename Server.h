@@ -35,6 +35,10 @@ public:
 
     quint16 getPort();
 
+public slots:
+    //! plugin endpoint connected by InProcessTransport instead of a socket
+    void addInProcessModule(QString moduleName, QObject *endpoint);
+
 signals:
     // не путаем терминологию модуля и компонента:
     void moduleConnection(ModuleProxyONB* in_pConnection);
@@ -0,0 +1,179 @@
+#include "StartupProfiler.h"
+
+#include <QHash>
+#include <QMutex>
+#include <QThread>
+#include <QVector>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QElapsedTimer>
+#include <QJsonDocument>
+#include <QCoreApplication>
+
+#include "PersistenceWorker.h"
+#include "GlobalConsole.h"
+
+QAtomicInt StartupProfiler::s_enabled {0};
+
+namespace
+{
+    struct ProfileEvent
+    {
+        char phase;
+        const char *category;
+        QString name;
+        qint64 timestamp;
+        qint64 duration;
+        quintptr thread;
+        QString id;
+        QString detail;
+    };
+
+    struct ProfileState
+    {
+        QMutex mutex;
+        QElapsedTimer clock;
+        QString path;
+        QVector<ProfileEvent> events;
+        QHash<quintptr, QString> threadNames;
+    };
+
+    ProfileState &state()
+    {
+        static ProfileState instance;
+        return instance;
+    }
+
+    void addEvent(ProfileEvent &&event)
+    {
+        ProfileState &s = state();
+        QThread *thread = QThread::currentThread();
+        event.thread = reinterpret_cast<quintptr>(thread);
+
+        QMutexLocker lock(&s.mutex);
+        if (!StartupProfiler::isEnabled())
+            return;
+        if (!s.threadNames.contains(event.thread))
+        {
+            QString name = thread->objectName();
+            if (name.isEmpty())
+                name = (QCoreApplication::instance() && thread == QCoreApplication::instance()->thread()) ?
+                            "main" : QString("thread %1").arg(s.threadNames.size());
+            s.threadNames[event.thread] = name;
+        }
+        s.events << std::move(event);
+    }
+}
+
+void StartupProfiler::start(const QString &path)
+{
+    ProfileState &s = state();
+    QMutexLocker lock(&s.mutex);
+    s.path = path;
+    s.events.clear();
+    s.events.reserve(1024);
+    s.clock.start();
+    s_enabled.store(1);
+}
+
+qint64 StartupProfiler::now()
+{
+    return state().clock.nsecsElapsed() / 1000;
+}
+
+void StartupProfiler::finish()
+{
+    ProfileState &s = state();
+    QJsonArray events;
+    QString path;
+
+    {
+        QMutexLocker lock(&s.mutex);
+        if (!s_enabled.load())
+            return;
+        s_enabled.store(0);
+        path = s.path;
+
+        for (auto it = s.threadNames.constBegin(); it != s.threadNames.constEnd(); ++it)
+        {
+            QJsonObject meta;
+            meta["ph"] = "M";
+            meta["name"] = "thread_name";
+            meta["pid"] = 1;
+            meta["tid"] = static_cast<double>(it.key());
+            meta["args"] = QJsonObject {{"name", it.value()}};
+            events << meta;
+        }
+
+        for (const ProfileEvent &event : s.events)
+        {
+            QJsonObject json;
+            json["ph"] = QString(QChar(event.phase));
+            json["cat"] = event.category;
+            json["name"] = event.name;
+            json["ts"] = static_cast<double>(event.timestamp);
+            json["pid"] = 1;
+            json["tid"] = static_cast<double>(event.thread);
+            if (event.phase == 'X')
+                json["dur"] = static_cast<double>(event.duration);
+            if (event.phase == 'i')
+                json["s"] = "t";
+            if (!event.id.isEmpty())
+                json["id"] = event.id;
+            if (!event.detail.isEmpty())
+                json["args"] = QJsonObject {{"detail", event.detail}};
+            events << json;
+        }
+        s.events.clear();
+    }
+
+    QJsonObject trace;
+    trace["traceEvents"] = events;
+    trace["displayTimeUnit"] = "ms";
+    PersistenceWorker::Instance()->writeFile(path, QJsonDocument(trace).toJson(QJsonDocument::Compact));
+    GlobalConsole::writeLine("Startup trace written: " + path);
+}
+
+void StartupProfiler::complete(const char *category, const char *name, qint64 startUs, qint64 durationUs, const QString &detail)
+{
+    if (!isEnabled())
+        return;
+    addEvent({'X', category, QString::fromLatin1(name), startUs, durationUs, 0, QString(), detail});
+}
+
+void StartupProfiler::instant(const char *category, const QString &name, const QString &detail)
+{
+    if (!isEnabled())
+        return;
+    addEvent({'i', category, name, now(), 0, 0, QString(), detail});
+}
+
+void StartupProfiler::beginAsync(const char *category, const QString &name, const QString &id)
+{
+    if (!isEnabled())
+        return;
+    addEvent({'b', category, name, now(), 0, 0, id, QString()});
+}
+
+void StartupProfiler::endAsync(const char *category, const QString &name, const QString &id)
+{
+    if (!isEnabled())
+        return;
+    addEvent({'e', category, name, now(), 0, 0, id, QString()});
+}
+
+StartupProfiler::Scope::Scope(const char *name, const QString &detail, const char *category) :
+    m_name(name),
+    m_category(category)
+{
+    if (!isEnabled())
+        return;
+    m_detail = detail;
+    m_start = now();
+}
+
+StartupProfiler::Scope::~Scope()
+{
+    if (m_start >= 0)
+        complete(m_category, m_name, m_start, now() - m_start, m_detail);
+}
@@ -0,0 +1,56 @@
+#ifndef STARTUPPROFILER_H
+#define STARTUPPROFILER_H
+
+#include <QString>
+#include <QAtomicInt>
+#include "xoCore_global.h"
+
+//! Timing probes of the boot sequence, written as a Chrome trace JSON file
+//! (chrome://tracing, ui.perfetto.dev). Recording is enabled by "--startup-trace [path]"
+//! and ends when the scheme starts, after MaxDurationMs or at exit, whatever comes first.
+//! Every probe is a single atomic check while recording is off.
+class XOCORESHARED_EXPORT StartupProfiler
+{
+public:
+    static const int MaxDurationMs = 120000;
+
+    static void start(const QString &path);
+    //! write the trace and stop recording, only the first call has an effect
+    static void finish();
+    static bool isEnabled() { return s_enabled.load(); }
+
+    //! microseconds since start()
+    static qint64 now();
+
+    static void complete(const char *category, const char *name, qint64 startUs, qint64 durationUs,
+                         const QString &detail = QString());
+    static void instant(const char *category, const QString &name, const QString &detail = QString());
+    //! spans which are not scoped, e.g. a module handshake; spans with the same id share a track
+    static void beginAsync(const char *category, const QString &name, const QString &id);
+    static void endAsync(const char *category, const QString &name, const QString &id);
+
+    class XOCORESHARED_EXPORT Scope
+    {
+    public:
+        explicit Scope(const char *name, const QString &detail = QString(), const char *category = "startup");
+        ~Scope();
+
+    private:
+        const char *m_name;
+        const char *m_category;
+        QString m_detail;
+        qint64 m_start = -1;
+    };
+
+private:
+    StartupProfiler() = delete;
+
+    static QAtomicInt s_enabled;
+};
+
+#define XO_PROFILE_CONCAT_(a, b) a##b
+#define XO_PROFILE_CONCAT(a, b) XO_PROFILE_CONCAT_(a, b)
+//! time the rest of the enclosing block: XO_PROFILE_SCOPE("name"[, detail[, category]])
+#define XO_PROFILE_SCOPE(...) StartupProfiler::Scope XO_PROFILE_CONCAT(xoProfileScope, __LINE__)(__VA_ARGS__)
+
+#endif // STARTUPPROFILER_H
@@ -0,0 +1,294 @@
+#include "Tracer.h"
+
+#include <QDebug>
+#include <QThread>
+#include <QElapsedTimer>
+#include <QWaitCondition>
+
+#include "GlobalConsole.h"
+
+QAtomicInt Tracer::s_levels[Tracer::CategoryCount] =
+{
+    Tracer::Info, Tracer::Info, Tracer::Info, Tracer::Info, Tracer::Info, Tracer::Info, Tracer::Info
+};
+
+namespace
+{
+    //! single producer (owning thread) / single consumer (drain thread)
+    class TraceRing
+    {
+    public:
+        static const quint32 Capacity = 4096; // power of two
+
+        bool push(TraceRecord &&record)
+        {
+            quint32 head = m_head.load();
+            if (head - m_tail.loadAcquire() >= Capacity)
+            {
+                m_dropped.fetchAndAddRelaxed(1);
+                return false;
+            }
+            m_records[head & (Capacity - 1)] = std::move(record);
+            m_head.storeRelease(head + 1);
+            return true;
+        }
+
+        template <typename F>
+        int drain(F consume)
+        {
+            quint32 tail = m_tail.load();
+            quint32 head = m_head.loadAcquire();
+            for (quint32 i = tail; i != head; i++)
+                consume(m_records[i & (Capacity - 1)]);
+            m_tail.storeRelease(head);
+            return static_cast<int>(head - tail);
+        }
+
+        quint64 dropped() const { return static_cast<quint64>(m_dropped.load()); }
+
+    private:
+        TraceRecord m_records[Capacity];
+        QAtomicInteger<quint32> m_head {0};
+        QAtomicInteger<quint32> m_tail {0};
+        QAtomicInt m_dropped {0};
+    };
+
+    class TraceDrain : public QThread
+    {
+    public:
+        static const int IntervalMs = 20;
+
+        TraceDrain()
+        {
+            m_clock.start();
+        }
+
+        TraceRing *registerRing()
+        {
+            QMutexLocker lock(&m_mutex);
+            auto ring = new TraceRing();
+            m_rings << ring;
+            if (!isRunning() && !m_stop)
+                start(QThread::LowestPriority);
+            return ring;
+        }
+
+        //! the owning thread is exiting: what it recorded is passed on, then the ring is freed
+        void unregisterRing(TraceRing *ring)
+        {
+            QMutexLocker lock(&m_mutex);
+            drainRing(ring);
+            m_rings.removeOne(ring);
+            m_retiredDropped += ring->dropped();
+            delete ring;
+        }
+
+        void addSink(TraceSink *sink)
+        {
+            QMutexLocker lock(&m_mutex);
+            m_sinks << sink;
+        }
+
+        void removeSink(TraceSink *sink)
+        {
+            QMutexLocker lock(&m_mutex);
+            m_sinks.removeOne(sink);
+            delete sink;
+        }
+
+        void stop()
+        {
+            {
+                QMutexLocker lock(&m_mutex);
+                m_stop = true;
+                m_condition.wakeOne();
+            }
+            wait();
+            drainAll();
+        }
+
+        quint64 dropped()
+        {
+            QMutexLocker lock(&m_mutex);
+            quint64 count = m_retiredDropped;
+            for (auto ring : m_rings)
+                count += ring->dropped();
+            return count;
+        }
+
+        qint64 now() const { return m_clock.nsecsElapsed(); }
+
+    protected:
+        void run() override
+        {
+            forever
+            {
+                {
+                    QMutexLocker lock(&m_mutex);
+                    if (m_stop)
+                        break;
+                    m_condition.wait(&m_mutex, IntervalMs);
+                }
+                drainAll();
+            }
+        }
+
+    private:
+        QMutex m_mutex;
+        QWaitCondition m_condition;
+        QList<TraceRing*> m_rings;
+        QList<TraceSink*> m_sinks;
+        QElapsedTimer m_clock;
+        bool m_stop = false;
+        quint64 m_retiredDropped = 0; //!< dropped by rings of threads that are gone
+
+        void drainAll()
+        {
+            QMutexLocker lock(&m_mutex);
+            for (auto ring : m_rings)
+                drainRing(ring);
+        }
+
+        //! m_mutex is held
+        void drainRing(TraceRing *ring)
+        {
+            ring->drain([this](const TraceRecord &record)
+            {
+                QString line = format(record);
+                for (auto sink : m_sinks)
+                    sink->write(record, line);
+            });
+        }
+
+        static QString format(const TraceRecord &record)
+        {
+            QString line = QString("[%1] %2")
+                    .arg(Tracer::categoryName(static_cast<Tracer::Category>(record.category)))
+                    .arg(QString::fromLatin1(record.message));
+            if (!record.text.isEmpty())
+                line += " " + record.text;
+            if (record.args[0] || record.args[1])
+                line += QString(" (%1, %2)").arg(record.args[0]).arg(record.args[1]);
+            return line;
+        }
+    };
+
+    TraceDrain *drain()
+    {
+        static TraceDrain *instance = new TraceDrain();
+        return instance;
+    }
+
+    //! pool threads come and go, so the ring goes away with its thread
+    struct LocalRing
+    {
+        TraceRing *ring = nullptr;
+
+        ~LocalRing()
+        {
+            if (ring)
+                drain()->unregisterRing(ring);
+        }
+    };
+
+    thread_local LocalRing localRing;
+}
+
+void Tracer::setLevel(Category category, Level level)
+{
+    s_levels[category].store(level);
+}
+
+void Tracer::setLevel(Level level)
+{
+    for (int i = 0; i < CategoryCount; i++)
+        s_levels[i].store(level);
+}
+
+void Tracer::configure(const QString &spec)
+{
+    for (const QString &item : spec.split(','))
+    {
+        if (item.trimmed().isEmpty())
+            continue;
+
+        QStringList pair = item.split('=');
+        if (pair.size() == 1)
+        {
+            setLevel(static_cast<Level>(pair[0].trimmed().toInt()));
+            continue;
+        }
+
+        QString name = pair[0].trimmed();
+        for (int i = 0; i < CategoryCount; i++)
+            if (name.compare(categoryName(static_cast<Category>(i)), Qt::CaseInsensitive) == 0)
+                setLevel(static_cast<Category>(i), static_cast<Level>(pair[1].trimmed().toInt()));
+    }
+}
+
+const char *Tracer::categoryName(Category category)
+{
+    switch (category)
+    {
+        case Core: return "Core";
+        case Hub: return "Hub";
+        case Link: return "Link";
+        case Component: return "Component";
+        case Module: return "Module";
+        case Loader: return "Loader";
+        case Scheme: return "Scheme";
+        default: return "?";
+    }
+}
+
+void Tracer::record(Level level, Category category, const char *message, const QString &text, qint64 arg0, qint64 arg1)
+{
+    if (!localRing.ring)
+        localRing.ring = drain()->registerRing();
+
+    TraceRecord record;
+    record.timestampNs = drain()->now();
+    record.level = static_cast<quint8>(level);
+    record.category = static_cast<quint8>(category);
+    record.message = message;
+    record.text = text;
+    record.args[0] = arg0;
+    record.args[1] = arg1;
+    record.thread = reinterpret_cast<quintptr>(QThread::currentThreadId());
+    localRing.ring->push(std::move(record));
+}
+
+void Tracer::addSink(TraceSink *sink)
+{
+    drain()->addSink(sink);
+}
+
+void Tracer::removeSink(TraceSink *sink)
+{
+    drain()->removeSink(sink);
+}
+
+void Tracer::shutdown()
+{
+    drain()->stop();
+}
+
+quint64 Tracer::droppedCount()
+{
+    return drain()->dropped();
+}
+
+ConsoleTraceSink::ConsoleTraceSink(QObject *parent) : QObject(parent)
+{
+    connect(this, &ConsoleTraceSink::lineReady, this, [](QString line) { GlobalConsole::writeLine(line); }, Qt::QueuedConnection);
+}
+
+void ConsoleTraceSink::write(const TraceRecord &, const QString &line)
+{
+    emit lineReady(line);
+}
+
+void DebugTraceSink::write(const TraceRecord &, const QString &line)
+{
+    qDebug().noquote() << line;
+}
@@ -0,0 +1,127 @@
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <QList>
+#include <QMutex>
+#include <QObject>
+#include <QString>
+#include <QAtomicInt>
+#include "xoCore_global.h"
+
+//! Levels above XO_TRACE_LEVEL are removed at compile time
+#ifndef XO_TRACE_LEVEL
+#  ifdef QT_DEBUG
+#    define XO_TRACE_LEVEL 4
+#  else
+#    define XO_TRACE_LEVEL 3
+#  endif
+#endif
+
+struct TraceRecord
+{
+    qint64 timestampNs = 0;
+    quint8 level = 0;
+    quint8 category = 0;
+    const char *message = nullptr; //!< string literal, never formatted on the hot path
+    QString text;                   //!< optional, implicitly shared
+    qint64 args[2] = {0, 0};
+    quint64 thread = 0;
+};
+
+class XOCORESHARED_EXPORT TraceSink
+{
+public:
+    virtual ~TraceSink() {}
+    //! called from the drain thread
+    virtual void write(const TraceRecord &record, const QString &line) = 0;
+};
+
+//! Low-overhead tracing: records are put into a lock-free per-thread ring buffer
+//! and formatted by a background thread that passes them to the registered sinks.
+class XOCORESHARED_EXPORT Tracer
+{
+public:
+    enum Level
+    {
+        Error = 1,
+        Warning = 2,
+        Info = 3,
+        Debug = 4,
+        Verbose = 5
+    };
+
+    enum Category
+    {
+        Core,
+        Hub,
+        Link,
+        Component,
+        Module,
+        Loader,
+        Scheme,
+        CategoryCount
+    };
+
+    static bool isEnabled(Level level, Category category)
+    {
+        return level <= s_levels[category].load();
+    }
+
+    static void setLevel(Category category, Level level);
+    static void setLevel(Level level);
+    //! "hub=4,link=5" or a single level applied to every category
+    static void configure(const QString &spec);
+
+    static const char *categoryName(Category category);
+
+    static void record(Level level, Category category, const char *message,
+                       const QString &text = QString(), qint64 arg0 = 0, qint64 arg1 = 0);
+
+    //! sinks are owned by the tracer
+    static void addSink(TraceSink *sink);
+    static void removeSink(TraceSink *sink);
+
+    //! drain whatever is buffered and stop the background thread
+    static void shutdown();
+
+    //! records dropped because a ring buffer was full
+    static quint64 droppedCount();
+
+private:
+    Tracer() = delete;
+
+    static QAtomicInt s_levels[CategoryCount];
+};
+
+#define XO_TRACE(level, category, ...) \
+    do { \
+        if (Tracer::level <= XO_TRACE_LEVEL && Tracer::isEnabled(Tracer::level, Tracer::category)) \
+            Tracer::record(Tracer::level, Tracer::category, __VA_ARGS__); \
+    } while (0)
+
+#define XO_TRACE_ERROR(category, ...)   XO_TRACE(Error, category, __VA_ARGS__)
+#define XO_TRACE_WARNING(category, ...) XO_TRACE(Warning, category, __VA_ARGS__)
+#define XO_TRACE_INFO(category, ...)    XO_TRACE(Info, category, __VA_ARGS__)
+#define XO_TRACE_DEBUG(category, ...)   XO_TRACE(Debug, category, __VA_ARGS__)
+#define XO_TRACE_VERBOSE(category, ...) XO_TRACE(Verbose, category, __VA_ARGS__)
+
+//! forwards trace lines to GlobalConsole on the thread it was created in (the main one)
+class XOCORESHARED_EXPORT ConsoleTraceSink : public QObject, public TraceSink
+{
+    Q_OBJECT
+public:
+    explicit ConsoleTraceSink(QObject *parent = nullptr);
+    void write(const TraceRecord &record, const QString &line) override;
+
+signals:
+    void lineReady(QString line);
+};
+
+//! forwards trace lines to qDebug()
+class XOCORESHARED_EXPORT DebugTraceSink : public TraceSink
+{
+public:
+    void write(const TraceRecord &record, const QString &line) override;
+};
+
+#endif // TRACER_H
@@ -20,16 +20,34 @@ SOURCES += \
     Data/ComponentConnection.cpp \
     Data/ComponentInfo.cpp \
     Loader.cpp \
+    Module/ClassCache.cpp \
+    Module/DeltaCodec.cpp \
+    Module/ImageFrame.cpp \
+    Module/InProcessTransport.cpp \
+    Module/LinkFilter.cpp \
+    Module/ObjectBatch.cpp \
+    Module/ObjectObserver.cpp \
     Module/ObjectProxy.cpp \
     ONBMetaDescriptor.cpp \
     ONBSettings.cpp \
     ConfigManager.cpp \
+    ConfigCatalog.cpp \
     ModuleConfig.cpp \
+    PersistenceWorker.cpp \
     Scheme.cpp \
+    SchemeCache.cpp \
+    SchemeJournal.cpp \
+    StartupProfiler.cpp \
     Hub.cpp \
     ModuleList.cpp \
+    ModuleProcess.cpp \
+    ModuleSupervisor.cpp \
+    ModuleWarmPool.cpp \
+    ModuleMonitor.cpp \
     Core.cpp \
+    ScriptBridge.cpp \
     ScriptEngineWrapper.cpp \
+    Tracer.cpp \
     Server.cpp \
     PluginManager.cpp \
     Module/ComponentProxyONB.cpp \
@@ -40,18 +58,36 @@ SOURCES += \
 
 HEADERS += \
     Loader.h \
+    ScriptBridge.h \
     ScriptEngineWrapper.h \
+    Tracer.h \
     xoCore_global.h \
     xoCorePlugin.h \
     ComponentsConfigParser.h \
     Data/ComponentConnection.h \
     Data/ComponentInfo.h \
+    Module/ClassCache.h \
+    Module/DeltaCodec.h \
+    Module/ImageFrame.h \
+    Module/InProcessTransport.h \
+    Module/LinkFilter.h \
+    Module/ObjectBatch.h \
+    Module/ObjectObserver.h \
+    Module/ONBExtensions.h \
     Module/ObjectProxy.h \
     ModuleConfig.h \
+    PersistenceWorker.h \
+    ModuleProcess.h \
     ModuleStartType.h \
+    ModuleSupervisor.h \
+    ModuleWarmPool.h \
+    ModuleMonitor.h \
     ONBMetaDescriptor.h \
     ONBSettings.h \
     Scheme.h \
+    SchemeCache.h \
+    SchemeJournal.h \
+    StartupProfiler.h \
     Hub.h \
     ModuleList.h \
     Core.h \
@@ -61,6 +97,7 @@ HEADERS += \
     Module/ModuleProxyONB.h \
     ONBMetaDescription.h \
     ConfigManager.h \
+    ConfigCatalog.h \
     xoPrimitiveConsole.h
 
 